@@ -0,0 +1,143 @@
+#ifndef ACTIVENOTES_H
+#define ACTIVENOTES_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "MidiMessage.h"
+
+/**
+ * Bitmap of the notes currently sounding on the device, one 128-bit set per
+ * MIDI channel.
+ *
+ * The serial transport updates it from every note-on/off it writes, so it
+ * reflects what reached the wire rather than what producers asked for: a
+ * note-off dropped on a full ring leaves its note marked. CC 120/123 clear
+ * their channel. For each note the source that started it and its onset
+ * time are kept too, for the stuck-note watchdog.
+ *
+ * Only the transport thread writes. The bitmap words are atomic so other
+ * threads can read count() and isActive() at any time.
+ */
+class ActiveNotes
+{
+public:
+    static constexpr int CHANNELS = 16;
+
+    void track(const MidiMessage& message, qint64 nowUs)
+    {
+        apply(message.status(), message.data1(), message.data2(), message.source, nowUs);
+    }
+
+    bool isActive(int channel, int note) const
+    {
+        return (word(channel, note).load(std::memory_order_relaxed) >> (note & 63)) & 1;
+    }
+
+    int count() const
+    {
+        int total = 0;
+        for (const auto& bits : m_bits) {
+            uint64_t value = bits.load(std::memory_order_relaxed);
+            while (value) {
+                value &= value - 1;
+                total++;
+            }
+        }
+        return total;
+    }
+
+    uint8_t source(int channel, int note) const { return m_sources[channel * 128 + note]; }
+    qint64 onsetUs(int channel, int note) const { return m_onsetUs[channel * 128 + note]; }
+
+    // Calls sink(channel, note) for every active note where
+    // match(channel, note) is true and marks it released; returns the count
+    template <typename Match, typename Sink>
+    int release(Match match, Sink sink)
+    {
+        int released = 0;
+        for (int channel = 0; channel < CHANNELS; channel++) {
+            for (int half = 0; half < 2; half++) {
+                uint64_t bits = m_bits[channel * 2 + half].load(std::memory_order_relaxed);
+                while (bits) {
+                    int note = half * 64 + countTrailingZeros(bits);
+                    bits &= bits - 1;
+                    if (match(channel, note)) {
+                        sink(channel, note);
+                        clear(channel, note);
+                        released++;
+                    }
+                }
+            }
+        }
+        return released;
+    }
+
+    void reset()
+    {
+        for (auto& bits : m_bits) {
+            bits.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    void apply(uint8_t status, uint8_t data1, uint8_t data2, uint8_t source, qint64 nowUs)
+    {
+        int channel = status & 0x0F;
+        switch (status & 0xF0) {
+            case 0x90:
+                if (data2 > 0) {
+                    set(channel, data1 & 0x7F, source, nowUs);
+                    break;
+                }
+                [[fallthrough]];
+            case 0x80:
+                clear(channel, data1 & 0x7F);
+                break;
+            case 0xB0:
+                if (data1 == 120 || data1 == 123) {
+                    m_bits[channel * 2].store(0, std::memory_order_relaxed);
+                    m_bits[channel * 2 + 1].store(0, std::memory_order_relaxed);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    void set(int channel, int note, uint8_t source, qint64 nowUs)
+    {
+        m_sources[channel * 128 + note] = source;
+        m_onsetUs[channel * 128 + note] = nowUs;
+        std::atomic<uint64_t>& bits = word(channel, note);
+        bits.store(bits.load(std::memory_order_relaxed) | (uint64_t(1) << (note & 63)),
+                   std::memory_order_relaxed);
+    }
+
+    void clear(int channel, int note)
+    {
+        std::atomic<uint64_t>& bits = word(channel, note);
+        bits.store(bits.load(std::memory_order_relaxed) & ~(uint64_t(1) << (note & 63)),
+                   std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t>& word(int channel, int note) { return m_bits[channel * 2 + (note >> 6)]; }
+    const std::atomic<uint64_t>& word(int channel, int note) const { return m_bits[channel * 2 + (note >> 6)]; }
+
+    static int countTrailingZeros(uint64_t value)
+    {
+        int count = 0;
+        while (!(value & 1)) {
+            value >>= 1;
+            count++;
+        }
+        return count;
+    }
+
+    std::array<std::atomic<uint64_t>, CHANNELS * 2> m_bits{};
+    std::array<uint8_t, CHANNELS * 128> m_sources{};
+    std::array<qint64, CHANNELS * 128> m_onsetUs{};
+};
+
+#endif // ACTIVENOTES_H
@@ -90,7 +90,9 @@ void FMPatchEditor::setupUI()
         opsLayout->addWidget(m_operators[tfi]);
 
         connect(m_operators[tfi], &OperatorWidget::operatorChanged,
-                this, &FMPatchEditor::onOperatorChanged);
+                this, [this, tfi]() { onOperatorChanged(tfi); });
+        connect(m_operators[tfi], &OperatorWidget::parameterChanged,
+                this, [this, tfi](FMParam param, int value) { onOperatorParameterChanged(tfi, param, value); });
     }
 
     mainLayout->addWidget(opsGroup);
@@ -143,7 +145,7 @@ void FMPatchEditor::onAlgorithmChanged(int value)
     updateCarrierStates();
 
     if (!m_updating) {
-        emit patchChanged();
+        emit parameterChanged(-1, FMParam::Algorithm, static_cast<uint8_t>(value));
     }
 }
 
@@ -152,16 +154,14 @@ void FMPatchEditor::onFeedbackChanged(int value)
     m_patch.feedback = value;
 
     if (!m_updating) {
-        emit patchChanged();
+        emit parameterChanged(-1, FMParam::Feedback, static_cast<uint8_t>(value));
     }
 }
 
-void FMPatchEditor::onOperatorChanged()
+void FMPatchEditor::onOperatorChanged(int opIndex)
 {
     // Update internal patch state
-    for (int i = 0; i < 4; i++) {
-        m_patch.op[i] = m_operators[i]->getOperator();
-    }
+    m_patch.op[opIndex] = m_operators[opIndex]->getOperator();
 
     updateEnvelopeDisplays();
 
@@ -170,13 +170,25 @@ void FMPatchEditor::onOperatorChanged()
     }
 }
 
+void FMPatchEditor::onOperatorParameterChanged(int opIndex, FMParam param, int value)
+{
+    m_patch.op[opIndex] = m_operators[opIndex]->getOperator();
+
+    updateEnvelopeDisplays();
+
+    if (!m_updating) {
+        emit parameterChanged(opIndex, param, static_cast<uint8_t>(value));
+    }
+}
+
+// Envelope drags go through the operator spinboxes, which report the
+// single-parameter change back via onOperatorParameterChanged()
+
 void FMPatchEditor::onEnvelopeAttackChanged(int opIndex, int value)
 {
     if (m_updating) return;
 
     m_operators[opIndex]->setAR(value);
-    m_patch.op[opIndex].ar = value;
-    emit patchChanged();
 }
 
 void FMPatchEditor::onEnvelopeDecayChanged(int opIndex, int value)
@@ -184,8 +196,6 @@ void FMPatchEditor::onEnvelopeDecayChanged(int opIndex, int value)
     if (m_updating) return;
 
     m_operators[opIndex]->setDR(value);
-    m_patch.op[opIndex].dr = value;
-    emit patchChanged();
 }
 
 void FMPatchEditor::onEnvelopeSustainLevelChanged(int opIndex, int value)
@@ -193,8 +203,6 @@ void FMPatchEditor::onEnvelopeSustainLevelChanged(int opIndex, int value)
     if (m_updating) return;
 
     m_operators[opIndex]->setSL(value);
-    m_patch.op[opIndex].sl = value;
-    emit patchChanged();
 }
 
 void FMPatchEditor::onEnvelopeReleaseChanged(int opIndex, int value)
@@ -202,8 +210,6 @@ void FMPatchEditor::onEnvelopeReleaseChanged(int opIndex, int value)
     if (m_updating) return;
 
     m_operators[opIndex]->setRR(value);
-    m_patch.op[opIndex].rr = value;
-    emit patchChanged();
 }
 
 void FMPatchEditor::updateCarrierStates()
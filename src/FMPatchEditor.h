@@ -25,12 +25,17 @@ public:
     FMPatch patch() const;
 
 signals:
+    // Several fields changed at once (operator paste/reset)
     void patchChanged();
+    // A single field was edited; opIndex is the TFI operator index, or -1
+    // for Algorithm/Feedback
+    void parameterChanged(int opIndex, FMParam param, uint8_t value);
 
 private slots:
     void onAlgorithmChanged(int value);
     void onFeedbackChanged(int value);
-    void onOperatorChanged();
+    void onOperatorChanged(int opIndex);
+    void onOperatorParameterChanged(int opIndex, FMParam param, int value);
     void onEnvelopeAttackChanged(int opIndex, int value);
     void onEnvelopeDecayChanged(int opIndex, int value);
     void onEnvelopeSustainLevelChanged(int opIndex, int value);
@@ -1,6 +1,10 @@
 #include "MIDIManager.h"
+#include "SerialManager.h"
+#include "MidiParser.h"
 #include <QDebug>
-#include <QTimer>
+#include <array>
+#include <atomic>
+#include <chrono>
 
 // =============================================================================
 // Platform-specific includes and implementation
@@ -9,8 +13,15 @@
 #if defined(USE_COREMIDI)
     #include <CoreMIDI/CoreMIDI.h>
     #include <CoreFoundation/CoreFoundation.h>
+    #include <mach/mach_time.h>
 #elif defined(USE_ALSA)
     #include <alsa/asoundlib.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #include <cstring>
+    #include <mutex>
+    #include <thread>
 #elif defined(USE_RTMIDI)
     #include <rtmidi/RtMidi.h>
 #elif defined(USE_WINMM)
@@ -22,6 +33,41 @@
 // Private Implementation
 // =============================================================================
 
+class MIDIManagerPrivate;
+
+// One open input. Slots are fixed so callbacks can hold a stable pointer;
+// the source ID is the slot index
+struct InputSource {
+    MIDIManagerPrivate* d = nullptr;
+    uint8_t id = 0;
+    QString name;                           // GUI thread only
+    std::atomic<bool> open{false};
+
+    std::atomic<quint64> events{0};
+    std::atomic<quint64> bytes{0};
+    std::atomic<quint64> drops{0};
+
+#if defined(USE_COREMIDI)
+    MIDIEndpointRef endpoint = 0;
+    // Packets may hold several messages, running status, or a SysEx that
+    // continues into the next packet, so each source has its own parser
+    MidiParser parser{MAX_SYSEX_BYTES};
+    std::vector<MidiMessage> parsedBatch;
+    quint64 parserOverflows = 0;
+#elif defined(USE_ALSA)
+    snd_seq_addr_t address = {0, 0};
+    std::vector<uint8_t> sysExBuffer;       // Reserved on first use, reused after
+    bool sysExOverflow = false;
+#elif defined(USE_RTMIDI)
+    RtMidiIn* midiIn = nullptr;
+#elif defined(USE_WINMM)
+    HMIDIIN midiIn = nullptr;
+    qint64 startUs = 0;                     // Steady clock at midiInStart
+#endif
+
+    static constexpr size_t MAX_SYSEX_BYTES = 65536;
+};
+
 class MIDIManagerPrivate {
 public:
     MIDIManager* q;
@@ -29,110 +75,410 @@ public:
 #if defined(USE_COREMIDI)
     MIDIClientRef client = 0;
     MIDIPortRef inputPort = 0;
-    MIDIEndpointRef virtualSource = 0;
-    MIDIEndpointRef connectedSource = 0;
+    MIDIEndpointRef virtualDestination = 0;     // DAWs send to us
+    std::atomic<MIDIEndpointRef> virtualOutput{0};  // We send device traffic to DAWs
+    std::vector<Byte> outPacketBuffer;          // Serial transport thread only
 
+    // All sources connected to one port are delivered on one CoreMIDI
+    // thread, already in host-time order; connRefCon identifies the source.
+    // The virtual destination passes its source as readProcRefCon instead.
     static void midiReadProc(const MIDIPacketList* pktList, void* readProcRefCon, void* srcConnRefCon) {
-        auto* d = static_cast<MIDIManagerPrivate*>(readProcRefCon);
+        auto* source = static_cast<InputSource*>(srcConnRefCon ? srcConnRefCon : readProcRefCon);
+        if (!source) return;
+        MIDIManagerPrivate* d = source->d;
+
         const MIDIPacket* packet = &pktList->packet[0];
         for (UInt32 i = 0; i < pktList->numPackets; i++) {
-            std::vector<uint8_t> data(packet->data, packet->data + packet->length);
-            d->processMessage(data);
+            qint64 timestampUs = hostTimeToUs(packet->timeStamp);
+            source->parsedBatch.clear();
+            source->parser.parse(reinterpret_cast<const char*>(packet->data), packet->length,
+                                 source->parsedBatch, [d, source, timestampUs](const QByteArray& sysex) {
+                d->processSysEx(*source, SysExMessage::fromBytes(
+                    reinterpret_cast<const uint8_t*>(sysex.constData()), sysex.size(), timestampUs));
+            }, timestampUs);
+            for (const MidiMessage& message : source->parsedBatch) {
+                d->processMessage(*source, message);
+            }
             packet = MIDIPacketNext(packet);
         }
+
+        quint64 overflows = source->parser.overflowCount();
+        if (overflows != source->parserOverflows) {
+            source->drops.fetch_add(overflows - source->parserOverflows, std::memory_order_relaxed);
+            source->parserOverflows = overflows;
+        }
+    }
+
+    static qint64 hostTimeToUs(MIDITimeStamp hostTime) {
+        if (hostTime == 0) return steadyNowUs();  // "Now" - stamp on arrival
+        static mach_timebase_info_data_t timebase = []() {
+            mach_timebase_info_data_t info;
+            mach_timebase_info(&info);
+            return info;
+        }();
+        return static_cast<qint64>(hostTime * timebase.numer / timebase.denom / 1000);
+    }
+
+    void sendToVirtualOutput(const uint8_t* data, size_t size) {
+        MIDIEndpointRef output = virtualOutput.load(std::memory_order_acquire);
+        if (!output || size > 65535) return;
+
+        size_t needed = sizeof(MIDIPacketList) + size;
+        if (outPacketBuffer.size() < needed) {
+            outPacketBuffer.resize(needed);
+        }
+        auto* list = reinterpret_cast<MIDIPacketList*>(outPacketBuffer.data());
+        MIDIPacket* packet = MIDIPacketListInit(list);
+        packet = MIDIPacketListAdd(list, outPacketBuffer.size(), packet, 0, size, data);
+        if (packet) {
+            MIDIReceived(output, list);
+        }
     }
 
 #elif defined(USE_ALSA)
     snd_seq_t* seq = nullptr;
+    snd_seq_t* outputSeq = nullptr;          // Echo output only, see sendToVirtualOutput
+    std::mutex outputMutex;                  // Guards outputSeq
     int clientId = -1;
     int inputPortId = -1;
-    int virtualPortId = -1;
-    QTimer* pollTimer = nullptr;
+    int virtualPortId = -1;                  // Writable: DAWs send to us
+    std::atomic<int> virtualOutputPortId{-1};  // Readable: we send device traffic to DAWs
+    int queueId = -1;             // Real-time queue that timestamps subscribed input
+    qint64 queueStartUs = 0;      // Steady clock when the queue started
+    std::thread readerThread;
+    int wakePipe[2] = {-1, -1};   // Written once to stop the reader
+
+    // Largest snd_midi_event_decode() output: an NRPN is four 3-byte CCs
+    static constexpr size_t MAX_DECODED_BYTES = 4 * 3;
+
+    // Blocks on the sequencer's poll descriptors, so input costs nothing
+    // while idle and is handled as soon as the kernel delivers it. Every
+    // subscription lands in the same sequencer FIFO, so events from all
+    // sources arrive here already merged in arrival order.
+    void readerLoop() {
+        int count = snd_seq_poll_descriptors_count(seq, POLLIN);
+        std::vector<pollfd> fds(count + 1);
+        snd_seq_poll_descriptors(seq, fds.data(), count, POLLIN);
+        fds[count].fd = wakePipe[0];
+        fds[count].events = POLLIN;
+
+        for (;;) {
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                qWarning() << "ALSA poll failed:" << strerror(errno);
+                return;
+            }
+            if (fds[count].revents & POLLIN) {
+                return;  // Shutdown
+            }
+
+            // Non-blocking: drains everything queued, then returns -EAGAIN
+            snd_seq_event_t* ev;
+            while (snd_seq_event_input(seq, &ev) >= 0) {
+                handleEvent(ev);
+                snd_seq_free_event(ev);
+            }
+        }
+    }
+
+    InputSource& sourceFor(const snd_seq_addr_t& sender) {
+        for (int i = 0; i < MIDIManager::MAX_INPUTS; i++) {
+            InputSource& source = sources[i];
+            if (source.open.load(std::memory_order_acquire) &&
+                source.address.client == sender.client && source.address.port == sender.port) {
+                return source;
+            }
+        }
+        return sources[MIDIManager::DIRECT_SOURCE];
+    }
+
+    void handleEvent(const snd_seq_event_t* ev) {
+        InputSource& source = sourceFor(ev->source);
+
+        // Subscribed input is stamped on arrival by our queue; rebase it
+        // onto the steady clock so direct connections compare with it.
+        // Events sent straight to our ports carry the sender's queue time,
+        // which means nothing against our queue start.
+        qint64 arrivalTimeUs = steadyNowUs();
+        if (queueId >= 0 && ev->queue == queueId && snd_seq_ev_is_real(ev)) {
+            arrivalTimeUs = queueStartUs + static_cast<qint64>(ev->time.time.tv_sec) * 1000000
+                          + ev->time.time.tv_nsec / 1000;
+        }
+
+        if (ev->type == SND_SEQ_EVENT_SYSEX) {
+            appendSysExChunk(source, static_cast<const uint8_t*>(ev->data.ext.ptr),
+                             ev->data.ext.len, arrivalTimeUs);
+            return;
+        }
+
+        // Canonical byte encoding for every other MIDI event type;
+        // non-MIDI events (port/client announcements) decode to an error
+        if (!decoder) return;
+        uint8_t bytes[MAX_DECODED_BYTES];
+        long length = snd_midi_event_decode(decoder, bytes, sizeof(bytes), ev);
+        if (length <= 0) {
+            if (snd_seq_ev_is_channel_type(ev)) {
+                source.drops.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        // One event can decode to several messages (a 14-bit CC is two,
+        // an RPN/NRPN up to four), each with its own status byte
+        size_t offset = 0;
+        while (offset < static_cast<size_t>(length)) {
+            MidiMessage message = MidiMessage::fromBytes(bytes + offset,
+                                                         static_cast<size_t>(length) - offset,
+                                                         arrivalTimeUs);
+            if (message.isEmpty()) {
+                source.drops.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            processMessage(source, message);
+            offset += 1 + MidiMessage::dataLength(message.status());
+        }
+    }
+
+    // ALSA splits large SysEx into several events; rebuild the whole message
+    void appendSysExChunk(InputSource& source, const uint8_t* chunk, unsigned int length,
+                          qint64 arrivalTimeUs) {
+        if (length == 0) return;
+
+        std::vector<uint8_t>& buffer = source.sysExBuffer;
+        if (chunk[0] == 0xF0) {
+            if (buffer.capacity() == 0) {
+                buffer.reserve(InputSource::MAX_SYSEX_BYTES);
+            }
+            buffer.clear();
+            source.sysExOverflow = false;
+        } else if (buffer.empty()) {
+            return;  // Continuation without a start - we joined mid-message
+        }
+
+        if (buffer.size() + length > InputSource::MAX_SYSEX_BYTES) {
+            source.sysExOverflow = true;
+        } else if (!source.sysExOverflow) {
+            buffer.insert(buffer.end(), chunk, chunk + length);
+        }
+
+        if (chunk[length - 1] == 0xF7) {
+            if (source.sysExOverflow) {
+                qWarning() << "Dropped SysEx larger than" << InputSource::MAX_SYSEX_BYTES << "bytes";
+                source.drops.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                processSysEx(source, SysExMessage::fromBytes(buffer.data(), buffer.size(),
+                                                             arrivalTimeUs));
+            }
+            buffer.clear();
+            source.sysExOverflow = false;
+        }
+    }
+
+    bool subscribe(const snd_seq_addr_t& source, bool connect) {
+        snd_seq_port_subscribe_t* sub;
+        snd_seq_port_subscribe_alloca(&sub);
+        snd_seq_addr_t dest;
+        dest.client = static_cast<unsigned char>(clientId);
+        dest.port = static_cast<unsigned char>(inputPortId);
+        snd_seq_port_subscribe_set_sender(sub, &source);
+        snd_seq_port_subscribe_set_dest(sub, &dest);
+        if (connect && queueId >= 0) {
+            snd_seq_port_subscribe_set_queue(sub, queueId);
+            snd_seq_port_subscribe_set_time_update(sub, 1);
+            snd_seq_port_subscribe_set_time_real(sub, 1);
+        }
+        int err = connect ? snd_seq_subscribe_port(seq, sub) : snd_seq_unsubscribe_port(seq, sub);
+        if (err < 0) {
+            qWarning() << (connect ? "ALSA subscribe failed:" : "ALSA unsubscribe failed:")
+                       << snd_strerror(err);
+            return false;
+        }
+        return true;
+    }
+
+    // Direct (unqueued) delivery to everyone subscribed to the output port.
+    // alsa-lib doesn't make one snd_seq_t safe across threads, so the echo
+    // port lives on its own output-only client rather than on the handle
+    // the reader and GUI threads use. The lock only meets port creation and
+    // removal on the GUI thread. The handle is non-blocking, so a full
+    // kernel pool drops the event instead of stalling the transport.
+    void sendToVirtualOutput(snd_seq_event_t& ev) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        int port = virtualOutputPortId.load(std::memory_order_relaxed);
+        if (!outputSeq || port < 0) return;
+        snd_seq_ev_set_source(&ev, port);
+        snd_seq_ev_set_subs(&ev);
+        snd_seq_ev_set_direct(&ev);
+        snd_seq_event_output_direct(outputSeq, &ev);
+    }
+
+    snd_midi_event_t* decoder = nullptr;
+    snd_midi_event_t* encoder = nullptr;     // Serial transport thread only
 
 #elif defined(USE_RTMIDI)
-    RtMidiIn* midiIn = nullptr;
+    RtMidiIn* midiIn = nullptr;   // Port enumeration only; each source has its own
 
+    // RtMidi delivers one complete message per callback (SysEx reassembled),
+    // on a thread per open port
     static void midiCallback(double timeStamp, std::vector<unsigned char>* message, void* userData) {
-        Q_UNUSED(timeStamp);
-        auto* d = static_cast<MIDIManagerPrivate*>(userData);
-        if (message && !message->empty()) {
-            std::vector<uint8_t> data(message->begin(), message->end());
-            d->processMessage(data);
+        Q_UNUSED(timeStamp);  // Delta since previous message on this port only
+        auto* source = static_cast<InputSource*>(userData);
+        if (!message || message->empty()) return;
+
+        qint64 arrivalTimeUs = steadyNowUs();
+        if ((*message)[0] == 0xF0) {
+            source->d->processSysEx(*source, SysExMessage::fromBytes(message->data(), message->size(),
+                                                                     arrivalTimeUs));
+        } else {
+            source->d->processMessage(*source, MidiMessage::fromBytes(message->data(), message->size(),
+                                                                      arrivalTimeUs));
         }
     }
 
 #elif defined(USE_WINMM)
-    HMIDIIN midiIn = nullptr;
-    std::vector<uint8_t> sysExBuffer;
-
     static void CALLBACK midiInProc(HMIDIIN hMidiIn, UINT wMsg, DWORD_PTR dwInstance,
                                     DWORD_PTR dwParam1, DWORD_PTR dwParam2) {
         Q_UNUSED(hMidiIn);
-        Q_UNUSED(dwParam2);
-        auto* d = reinterpret_cast<MIDIManagerPrivate*>(dwInstance);
+        auto* source = reinterpret_cast<InputSource*>(dwInstance);
         if (wMsg == MIM_DATA) {
-            // Short message
-            std::vector<uint8_t> data;
-            data.push_back(dwParam1 & 0xFF);
-            data.push_back((dwParam1 >> 8) & 0xFF);
-            data.push_back((dwParam1 >> 16) & 0xFF);
-            d->processMessage(data);
+            // Short message packed into dwParam1; dwParam2 is ms since this
+            // device's midiInStart, rebased onto the shared steady clock
+            const uint8_t bytes[3] = {
+                static_cast<uint8_t>(dwParam1 & 0xFF),
+                static_cast<uint8_t>((dwParam1 >> 8) & 0xFF),
+                static_cast<uint8_t>((dwParam1 >> 16) & 0xFF)
+            };
+            source->d->processMessage(*source, MidiMessage::fromBytes(bytes, sizeof(bytes),
+                source->startUs + static_cast<qint64>(dwParam2) * 1000));
+        } else if (wMsg == MIM_ERROR) {
+            source->drops.fetch_add(1, std::memory_order_relaxed);
         }
     }
 #endif
 
-    QString currentPortName;
+    // Monotonic clock shared by every source, so merged events are comparable
+    static qint64 steadyNowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     bool hasVirtual = false;
 
-    void processMessage(const std::vector<uint8_t>& data) {
-        if (data.empty()) return;
+    // Slot MAX_INPUTS collects input nobody subscribed to (ALSA direct connections)
+    std::array<InputSource, MIDIManager::MAX_INPUTS + 1> sources;
 
-        // Emit raw data for forwarding
-        emit q->midiReceived(data);
+    int freeSource() const {
+        for (int i = 0; i < MIDIManager::MAX_INPUTS; i++) {
+            if (!sources[i].open.load(std::memory_order_relaxed)) return i;
+        }
+        return -1;
+    }
+
+    // Shared with the MIDI input threads
+    std::atomic<SerialManager*> forwardTarget{nullptr};
+    std::atomic<bool> forwardingEnabled{true};
+    std::atomic<quint64> receivedCount{0};
+    std::atomic<quint64> forwardedCount{0};
+    MidiRouter router;
+    VoiceAllocator voices;
+
+    // May run concurrently for different sources (RtMidi/WinMM callback
+    // threads); everything touched here is atomic, read-only, or (voice
+    // allocation) locked internally
+    void processMessage(InputSource& source, MidiMessage message) {
+        if (message.isEmpty()) {
+            source.drops.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        message.source = source.id;
+        source.events.fetch_add(1, std::memory_order_relaxed);
+        source.bytes.fetch_add(message.length, std::memory_order_relaxed);
+        receivedCount.fetch_add(1, std::memory_order_relaxed);
+
+        // Fast path: straight into the serial TX ring from this thread
+        SerialManager* serial = forwardTarget.load(std::memory_order_acquire);
+        if (serial && forwardingEnabled.load(std::memory_order_relaxed) && serial->isConnected()) {
+            bool dropped = false;
+            int sent = 0;
+            if (voices.handles(message)) {
+                // The allocator's input channel bypasses the routing table
+                VoiceAllocator::Output out[VoiceAllocator::MAX_OUTPUTS];
+                sent = voices.process(message, out);
+                for (int i = 0; i < sent; i++) {
+                    const VoiceAllocator::Output& o = out[i];
+                    dropped |= o.recallSlot >= 0
+                        ? !serial->recallPatchThenSend(o.message.channel(),
+                                                       static_cast<uint8_t>(o.recallSlot), o.message)
+                        : !serial->sendMidi(o.message);
+                    if (o.recallSlot >= 0 || o.message.type() == 0xC0) {
+                        emit q->channelPatchChanged(o.message.channel());
+                    }
+                }
+            } else {
+                sent = router.route(message, [this, serial, &dropped](const MidiMessage& routed) {
+                    dropped |= !serial->sendMidi(routed);
+                    if (routed.type() == 0xC0) {
+                        emit q->channelPatchChanged(routed.channel());
+                    }
+                });
+            }
+            if (dropped) {
+                source.drops.fetch_add(1, std::memory_order_relaxed);
+            } else if (sent > 0) {
+                forwardedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Emit raw message for monitoring
+        emit q->midiReceived(message);
 
         // Parse and emit typed events
-        uint8_t status = data[0];
-        uint8_t type = status & 0xF0;
-        uint8_t channel = status & 0x0F;
+        uint8_t channel = message.channel();
 
-        switch (type) {
+        switch (message.type()) {
             case 0x90:  // Note On
-                if (data.size() >= 3) {
-                    if (data[2] > 0) {
-                        emit q->noteOnReceived(channel, data[1], data[2]);
-                    } else {
-                        emit q->noteOffReceived(channel, data[1], 0);
-                    }
+                if (message.data2() > 0) {
+                    emit q->noteOnReceived(channel, message.data1(), message.data2());
+                } else {
+                    emit q->noteOffReceived(channel, message.data1(), 0);
                 }
                 break;
             case 0x80:  // Note Off
-                if (data.size() >= 3) {
-                    emit q->noteOffReceived(channel, data[1], data[2]);
-                }
+                emit q->noteOffReceived(channel, message.data1(), message.data2());
                 break;
             case 0xB0:  // Control Change
-                if (data.size() >= 3) {
-                    emit q->controlChangeReceived(channel, data[1], data[2]);
-                }
+                emit q->controlChangeReceived(channel, message.data1(), message.data2());
                 break;
             case 0xC0:  // Program Change
-                if (data.size() >= 2) {
-                    emit q->programChangeReceived(channel, data[1]);
-                }
+                emit q->programChangeReceived(channel, message.data1());
                 break;
             case 0xE0:  // Pitch Bend
-                if (data.size() >= 3) {
-                    uint16_t value = data[1] | (data[2] << 7);
-                    emit q->pitchBendReceived(channel, value);
-                }
-                break;
-            case 0xF0:  // System messages
-                if (status == 0xF0) {
-                    emit q->sysExReceived(data);
-                }
+                emit q->pitchBendReceived(channel, static_cast<uint16_t>(
+                    message.data1() | (message.data2() << 7)));
                 break;
         }
     }
+
+    void processSysEx(InputSource& source, SysExMessage message) {
+        if (message.isEmpty()) return;
+
+        message.setSource(source.id);
+        source.events.fetch_add(1, std::memory_order_relaxed);
+        source.bytes.fetch_add(message.size(), std::memory_order_relaxed);
+        receivedCount.fetch_add(1, std::memory_order_relaxed);
+
+        SerialManager* serial = forwardTarget.load(std::memory_order_acquire);
+        if (serial && forwardingEnabled.load(std::memory_order_relaxed) && serial->isConnected()) {
+            if (serial->sendRawSysEx(message)) {
+                forwardedCount.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                source.drops.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        emit q->sysExReceived(message);
+    }
 };
 
 // =============================================================================
@@ -142,16 +488,25 @@ public:
 MIDIManager::MIDIManager(QObject* parent)
     : QObject(parent)
     , d(std::make_unique<MIDIManagerPrivate>())
-    , m_forwardingEnabled(true)
 {
     d->q = this;
+    for (size_t i = 0; i < d->sources.size(); i++) {
+        d->sources[i].d = d.get();
+        d->sources[i].id = static_cast<uint8_t>(i);
+    }
+
+    // Senders connected to our ports from outside (virtual input, ALSA
+    // "Input" port) count as one source
+    d->sources[DIRECT_SOURCE].name = "Direct connections";
+    d->sources[DIRECT_SOURCE].open.store(true, std::memory_order_release);
 
 #if defined(USE_COREMIDI)
     CFStringRef clientName = CFSTR("GenesisEngineSynth");
     MIDIClientCreate(clientName, nullptr, nullptr, &d->client);
 
     CFStringRef portName = CFSTR("Input");
-    MIDIInputPortCreate(d->client, portName, MIDIManagerPrivate::midiReadProc, d.get(), &d->inputPort);
+    MIDIInputPortCreate(d->client, portName, MIDIManagerPrivate::midiReadProc, nullptr, &d->inputPort);
+    d->outPacketBuffer.resize(1024);
 
 #elif defined(USE_ALSA)
     if (snd_seq_open(&d->seq, "default", SND_SEQ_OPEN_DUPLEX, 0) >= 0) {
@@ -163,55 +518,40 @@ MIDIManager::MIDIManager(QObject* parent)
             SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
             SND_SEQ_PORT_TYPE_APPLICATION);
 
-        // Poll timer for ALSA events
-        d->pollTimer = new QTimer(this);
-        connect(d->pollTimer, &QTimer::timeout, this, [this]() {
-            snd_seq_event_t* ev;
-            while (snd_seq_event_input_pending(d->seq, 1) > 0) {
-                snd_seq_event_input(d->seq, &ev);
-                // Convert ALSA event to MIDI bytes
-                std::vector<uint8_t> data;
-                switch (ev->type) {
-                    case SND_SEQ_EVENT_NOTEON:
-                        data = {static_cast<uint8_t>(0x90 | ev->data.note.channel),
-                                ev->data.note.note, ev->data.note.velocity};
-                        break;
-                    case SND_SEQ_EVENT_NOTEOFF:
-                        data = {static_cast<uint8_t>(0x80 | ev->data.note.channel),
-                                ev->data.note.note, ev->data.note.velocity};
-                        break;
-                    case SND_SEQ_EVENT_CONTROLLER:
-                        data = {static_cast<uint8_t>(0xB0 | ev->data.control.channel),
-                                static_cast<uint8_t>(ev->data.control.param),
-                                static_cast<uint8_t>(ev->data.control.value)};
-                        break;
-                    case SND_SEQ_EVENT_PGMCHANGE:
-                        data = {static_cast<uint8_t>(0xC0 | ev->data.control.channel),
-                                static_cast<uint8_t>(ev->data.control.value)};
-                        break;
-                    case SND_SEQ_EVENT_PITCHBEND:
-                        {
-                            int bend = ev->data.control.value + 8192;
-                            data = {static_cast<uint8_t>(0xE0 | ev->data.control.channel),
-                                    static_cast<uint8_t>(bend & 0x7F),
-                                    static_cast<uint8_t>((bend >> 7) & 0x7F)};
-                        }
-                        break;
-                }
-                if (!data.empty()) {
-                    d->processMessage(data);
-                }
-                snd_seq_free_event(ev);
-            }
-        });
-        d->pollTimer->start(1);  // 1ms polling
+        // Queue used only to timestamp subscribed input on arrival
+        d->queueId = snd_seq_alloc_named_queue(d->seq, "GenesisEngineSynth");
+        if (d->queueId >= 0) {
+            snd_seq_start_queue(d->seq, d->queueId, nullptr);
+            snd_seq_drain_output(d->seq);
+            d->queueStartUs = MIDIManagerPrivate::steadyNowUs();
+        }
+
+        // Decoder emits full status bytes so each message stands alone
+        if (snd_midi_event_new(0, &d->decoder) == 0) {
+            snd_midi_event_no_status(d->decoder, 1);
+        }
+        snd_midi_event_new(16, &d->encoder);
+
+        // Separate client for the echo output, written from the transport thread
+        if (snd_seq_open(&d->outputSeq, "default", SND_SEQ_OPEN_OUTPUT, SND_SEQ_NONBLOCK) >= 0) {
+            snd_seq_set_client_name(d->outputSeq, "GenesisEngineSynth Out");
+        } else {
+            d->outputSeq = nullptr;
+            qWarning() << "Failed to open ALSA output client for the virtual output";
+        }
+
+        // Reader thread wakes on the sequencer's poll descriptors
+        snd_seq_nonblock(d->seq, 1);
+        if (pipe(d->wakePipe) == 0) {
+            d->readerThread = std::thread([this]() { d->readerLoop(); });
+        } else {
+            qWarning() << "Failed to create ALSA reader wake pipe";
+        }
     }
 
 #elif defined(USE_RTMIDI)
     try {
         d->midiIn = new RtMidiIn();
-        d->midiIn->setCallback(MIDIManagerPrivate::midiCallback, d.get());
-        d->midiIn->ignoreTypes(false, false, false);  // Don't ignore SysEx, timing, sensing
     } catch (RtMidiError& error) {
         qWarning() << "RtMidi error:" << error.getMessage().c_str();
     }
@@ -223,16 +563,30 @@ MIDIManager::MIDIManager(QObject* parent)
 
 MIDIManager::~MIDIManager()
 {
-    closeInputPort();
+    closeAllInputPorts();
     destroyVirtualInputPort();
+    destroyVirtualOutputPort();
 
 #if defined(USE_COREMIDI)
     if (d->inputPort) MIDIPortDispose(d->inputPort);
     if (d->client) MIDIClientDispose(d->client);
 
 #elif defined(USE_ALSA)
-    if (d->pollTimer) d->pollTimer->stop();
+    if (d->readerThread.joinable()) {
+        char stop = 0;
+        if (write(d->wakePipe[1], &stop, 1) != 1) {
+            qWarning() << "Failed to wake ALSA reader thread";
+        }
+        d->readerThread.join();
+    }
+    for (int fd : d->wakePipe) {
+        if (fd >= 0) close(fd);
+    }
+    if (d->decoder) snd_midi_event_free(d->decoder);
+    if (d->encoder) snd_midi_event_free(d->encoder);
+    if (d->seq && d->queueId >= 0) snd_seq_free_queue(d->seq, d->queueId);
     if (d->seq) snd_seq_close(d->seq);
+    if (d->outputSeq) snd_seq_close(d->outputSeq);
 
 #elif defined(USE_RTMIDI)
     delete d->midiIn;
@@ -311,64 +665,97 @@ void MIDIManager::refreshPorts()
     emit portsChanged();
 }
 
-bool MIDIManager::openInputPort(int portIndex)
+int MIDIManager::openInputPort(int portIndex)
 {
-    closeInputPort();
+    QString name = availableInputPorts().value(portIndex);
+    if (name.isEmpty()) {
+        return -1;
+    }
 
-#if defined(USE_COREMIDI)
-    if (portIndex >= 0 && portIndex < (int)MIDIGetNumberOfSources()) {
-        d->connectedSource = MIDIGetSource(portIndex);
-        MIDIPortConnectSource(d->inputPort, d->connectedSource, nullptr);
+    int existing = findInputSource(name);
+    if (existing >= 0) {
+        return existing;
+    }
 
-        CFStringRef name;
-        MIDIObjectGetStringProperty(d->connectedSource, kMIDIPropertyDisplayName, &name);
-        if (name) {
-            char buffer[256];
-            CFStringGetCString(name, buffer, sizeof(buffer), kCFStringEncodingUTF8);
-            d->currentPortName = QString::fromUtf8(buffer);
-            CFRelease(name);
-        }
-        emit inputOpened(d->currentPortName);
-        return true;
+    int id = d->freeSource();
+    if (id < 0) {
+        emit error(QString("At most %1 MIDI inputs can be open").arg(MAX_INPUTS));
+        return -1;
+    }
+    InputSource& source = d->sources[id];
+    source.events.store(0, std::memory_order_relaxed);
+    source.bytes.store(0, std::memory_order_relaxed);
+    source.drops.store(0, std::memory_order_relaxed);
+    bool opened = false;
+
+#if defined(USE_COREMIDI)
+    source.endpoint = MIDIGetSource(portIndex);
+    source.parser.reset();
+    source.parserOverflows = source.parser.overflowCount();
+    opened = MIDIPortConnectSource(d->inputPort, source.endpoint, &source) == noErr;
+    if (!opened) {
+        source.endpoint = 0;
     }
 
 #elif defined(USE_ALSA)
-    // ALSA uses subscription model - port is always "open" via virtual port
-    // For explicit connection, we'd parse the portIndex back to client:port
-    d->currentPortName = availableInputPorts().value(portIndex);
-    emit inputOpened(d->currentPortName);
-    return true;
+    // Names are "client:port - name" (see availableInputPorts)
+    QString address = name.section(" - ", 0, 0);
+    bool clientOk = false;
+    bool portOk = false;
+    int client = address.section(':', 0, 0).toInt(&clientOk);
+    int port = address.section(':', 1, 1).toInt(&portOk);
+    if (d->seq && clientOk && portOk) {
+        source.address.client = static_cast<unsigned char>(client);
+        source.address.port = static_cast<unsigned char>(port);
+        source.sysExBuffer.clear();
+        source.sysExOverflow = false;
+        // Published before subscribing so the first event is attributed
+        source.open.store(true, std::memory_order_release);
+        opened = d->subscribe(source.address, true);
+        if (!opened) {
+            source.open.store(false, std::memory_order_release);
+        }
+    }
 
 #elif defined(USE_RTMIDI)
-    if (d->midiIn && portIndex >= 0 && portIndex < (int)d->midiIn->getPortCount()) {
-        try {
-            d->midiIn->openPort(portIndex);
-            d->currentPortName = QString::fromStdString(d->midiIn->getPortName(portIndex));
-            emit inputOpened(d->currentPortName);
-            return true;
-        } catch (RtMidiError& error) {
-            emit this->error(QString::fromStdString(error.getMessage()));
-        }
+    try {
+        source.midiIn = new RtMidiIn();
+        source.midiIn->setCallback(MIDIManagerPrivate::midiCallback, &source);
+        source.midiIn->ignoreTypes(false, false, false);  // Don't ignore SysEx, timing, sensing
+        source.midiIn->openPort(portIndex);
+        opened = true;
+    } catch (RtMidiError& error) {
+        emit this->error(QString::fromStdString(error.getMessage()));
+        delete source.midiIn;
+        source.midiIn = nullptr;
     }
 
 #elif defined(USE_WINMM)
-    MMRESULT result = midiInOpen(&d->midiIn, portIndex,
+    MMRESULT result = midiInOpen(&source.midiIn, portIndex,
                                   (DWORD_PTR)MIDIManagerPrivate::midiInProc,
-                                  (DWORD_PTR)d.get(), CALLBACK_FUNCTION);
+                                  (DWORD_PTR)&source, CALLBACK_FUNCTION);
     if (result == MMSYSERR_NOERROR) {
-        midiInStart(d->midiIn);
-        MIDIINCAPS caps;
-        midiInGetDevCaps(portIndex, &caps, sizeof(caps));
-        d->currentPortName = QString::fromWCharArray(caps.szPname);
-        emit inputOpened(d->currentPortName);
-        return true;
+        source.startUs = MIDIManagerPrivate::steadyNowUs();
+        midiInStart(source.midiIn);
+        opened = true;
+    } else {
+        source.midiIn = nullptr;
     }
 #endif
 
-    return false;
+    if (!opened) {
+        emit error("Could not open MIDI input " + name);
+        return -1;
+    }
+
+    source.name = name;
+    source.open.store(true, std::memory_order_release);
+    qDebug() << "Opened MIDI input" << id << name;
+    emit inputOpened(id, name);
+    return id;
 }
 
-bool MIDIManager::openInputPort(const QString& portName)
+int MIDIManager::openInputPort(const QString& portName)
 {
     QStringList ports = availableInputPorts();
     int index = ports.indexOf(portName);
@@ -383,54 +770,110 @@ bool MIDIManager::openInputPort(const QString& portName)
         }
     }
 
-    return false;
+    return -1;
 }
 
-void MIDIManager::closeInputPort()
+void MIDIManager::closeInputPort(int sourceId)
 {
+    if (sourceId < 0 || sourceId >= MAX_INPUTS) return;
+    InputSource& source = d->sources[sourceId];
+    if (!source.open.load(std::memory_order_relaxed)) return;
+
 #if defined(USE_COREMIDI)
-    if (d->connectedSource) {
-        MIDIPortDisconnectSource(d->inputPort, d->connectedSource);
-        d->connectedSource = 0;
+    if (source.endpoint) {
+        MIDIPortDisconnectSource(d->inputPort, source.endpoint);
+        source.endpoint = 0;
     }
 
 #elif defined(USE_ALSA)
-    // Virtual port stays open
+    // The application "Input" port itself stays open for DAW connections
+    d->subscribe(source.address, false);
 
 #elif defined(USE_RTMIDI)
-    if (d->midiIn && d->midiIn->isPortOpen()) {
-        d->midiIn->closePort();
-    }
+    // Deleting joins the port's callback thread
+    delete source.midiIn;
+    source.midiIn = nullptr;
 
 #elif defined(USE_WINMM)
-    if (d->midiIn) {
-        midiInStop(d->midiIn);
-        midiInClose(d->midiIn);
-        d->midiIn = nullptr;
+    if (source.midiIn) {
+        midiInStop(source.midiIn);
+        midiInClose(source.midiIn);
+        source.midiIn = nullptr;
     }
 #endif
 
-    d->currentPortName.clear();
-    emit inputClosed();
+    source.open.store(false, std::memory_order_release);
+    qDebug() << "Closed MIDI input" << sourceId << source.name
+             << "events:" << source.events.load(std::memory_order_relaxed)
+             << "bytes:" << source.bytes.load(std::memory_order_relaxed)
+             << "drops:" << source.drops.load(std::memory_order_relaxed);
+    source.name.clear();
+    emit inputClosed(sourceId);
+}
+
+void MIDIManager::closeAllInputPorts()
+{
+    for (int id = 0; id < MAX_INPUTS; id++) {
+        closeInputPort(id);
+    }
+}
+
+int MIDIManager::closeVanishedInputPorts()
+{
+    const QStringList ports = availableInputPorts();
+    int closed = 0;
+    for (int id : openInputSources()) {
+        if (!ports.contains(d->sources[id].name)) {
+            qDebug() << "MIDI input" << id << "vanished:" << d->sources[id].name;
+            closeInputPort(id);
+            closed++;
+        }
+    }
+    return closed;
 }
 
 bool MIDIManager::isInputOpen() const
 {
-#if defined(USE_COREMIDI)
-    return d->connectedSource != 0;
-#elif defined(USE_ALSA)
-    return d->inputPortId >= 0;
-#elif defined(USE_RTMIDI)
-    return d->midiIn && d->midiIn->isPortOpen();
-#elif defined(USE_WINMM)
-    return d->midiIn != nullptr;
-#endif
-    return false;
+    return !openInputSources().isEmpty();
+}
+
+QList<int> MIDIManager::openInputSources() const
+{
+    QList<int> ids;
+    for (int id = 0; id < MAX_INPUTS; id++) {
+        if (d->sources[id].open.load(std::memory_order_relaxed)) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+QString MIDIManager::inputPortName(int sourceId) const
+{
+    if (sourceId < 0 || sourceId > DIRECT_SOURCE) return QString();
+    return d->sources[sourceId].name;
+}
+
+int MIDIManager::findInputSource(const QString& portName) const
+{
+    for (int id = 0; id < MAX_INPUTS; id++) {
+        const InputSource& source = d->sources[id];
+        if (source.open.load(std::memory_order_relaxed) && source.name == portName) {
+            return id;
+        }
+    }
+    return -1;
 }
 
-QString MIDIManager::currentInputPort() const
+MIDIManager::InputStats MIDIManager::inputStats(int sourceId) const
 {
-    return d->currentPortName;
+    InputStats stats;
+    if (sourceId < 0 || sourceId > DIRECT_SOURCE) return stats;
+    const InputSource& source = d->sources[sourceId];
+    stats.events = source.events.load(std::memory_order_relaxed);
+    stats.bytes = source.bytes.load(std::memory_order_relaxed);
+    stats.drops = source.drops.load(std::memory_order_relaxed);
+    return stats;
 }
 
 bool MIDIManager::canCreateVirtualPorts() const
@@ -449,18 +892,19 @@ bool MIDIManager::createVirtualInputPort(const QString& name)
     }
 
 #if defined(USE_COREMIDI)
-    if (d->virtualSource) {
+    if (d->virtualDestination) {
         return true;  // Already created
     }
 
     CFStringRef cfName = CFStringCreateWithCString(nullptr, name.toUtf8().constData(),
                                                     kCFStringEncodingUTF8);
-    OSStatus status = MIDISourceCreate(d->client, cfName, &d->virtualSource);
+    OSStatus status = MIDIDestinationCreate(d->client, cfName, MIDIManagerPrivate::midiReadProc,
+                                            &d->sources[DIRECT_SOURCE], &d->virtualDestination);
     CFRelease(cfName);
 
     if (status == noErr) {
         d->hasVirtual = true;
-        qDebug() << "Created virtual MIDI source:" << name;
+        qDebug() << "Created virtual MIDI destination:" << name;
         return true;
     }
 
@@ -469,8 +913,9 @@ bool MIDIManager::createVirtualInputPort(const QString& name)
         return true;  // Already created
     }
 
+    // Events DAWs send here are read like any other direct connection
     d->virtualPortId = snd_seq_create_simple_port(d->seq, name.toUtf8().constData(),
-        SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+        SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
         SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
 
     if (d->virtualPortId >= 0) {
@@ -486,9 +931,9 @@ bool MIDIManager::createVirtualInputPort(const QString& name)
 void MIDIManager::destroyVirtualInputPort()
 {
 #if defined(USE_COREMIDI)
-    if (d->virtualSource) {
-        MIDIEndpointDispose(d->virtualSource);
-        d->virtualSource = 0;
+    if (d->virtualDestination) {
+        MIDIEndpointDispose(d->virtualDestination);
+        d->virtualDestination = 0;
         d->hasVirtual = false;
     }
 
@@ -506,12 +951,175 @@ bool MIDIManager::hasVirtualPort() const
     return d->hasVirtual;
 }
 
+bool MIDIManager::createVirtualOutputPort(const QString& name)
+{
+#if defined(USE_COREMIDI)
+    if (d->virtualOutput.load(std::memory_order_relaxed)) {
+        return true;  // Already created
+    }
+
+    CFStringRef cfName = CFStringCreateWithCString(nullptr, name.toUtf8().constData(),
+                                                    kCFStringEncodingUTF8);
+    MIDIEndpointRef output = 0;
+    OSStatus status = MIDISourceCreate(d->client, cfName, &output);
+    CFRelease(cfName);
+
+    if (status == noErr) {
+        d->virtualOutput.store(output, std::memory_order_release);
+        qDebug() << "Created virtual MIDI source:" << name;
+        return true;
+    }
+
+#elif defined(USE_ALSA)
+    std::lock_guard<std::mutex> lock(d->outputMutex);
+    if (d->virtualOutputPortId.load(std::memory_order_relaxed) >= 0) {
+        return true;  // Already created
+    }
+    if (!d->outputSeq) {
+        return false;
+    }
+
+    int port = snd_seq_create_simple_port(d->outputSeq, name.toUtf8().constData(),
+        SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+        SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+
+    if (port >= 0) {
+        d->virtualOutputPortId.store(port, std::memory_order_release);
+        qDebug() << "Created virtual MIDI output port:" << name;
+        return true;
+    }
+#else
+    Q_UNUSED(name);
+#endif
+
+    return false;
+}
+
+void MIDIManager::destroyVirtualOutputPort()
+{
+#if defined(USE_COREMIDI)
+    MIDIEndpointRef output = d->virtualOutput.exchange(0, std::memory_order_acq_rel);
+    if (output) {
+        MIDIEndpointDispose(output);
+    }
+
+#elif defined(USE_ALSA)
+    std::lock_guard<std::mutex> lock(d->outputMutex);
+    int port = d->virtualOutputPortId.exchange(-1, std::memory_order_acq_rel);
+    if (port >= 0) {
+        snd_seq_delete_simple_port(d->outputSeq, port);
+    }
+#endif
+}
+
+bool MIDIManager::hasVirtualOutputPort() const
+{
+#if defined(USE_COREMIDI)
+    return d->virtualOutput.load(std::memory_order_relaxed) != 0;
+#elif defined(USE_ALSA)
+    return d->virtualOutputPortId.load(std::memory_order_relaxed) >= 0;
+#else
+    return false;
+#endif
+}
+
+void MIDIManager::sendToVirtualOutput(const MidiMessage& message)
+{
+    if (message.isEmpty()) return;
+
+#if defined(USE_COREMIDI)
+    d->sendToVirtualOutput(message.bytes, message.length);
+
+#elif defined(USE_ALSA)
+    if (!d->encoder || d->virtualOutputPortId.load(std::memory_order_relaxed) < 0) return;
+    snd_seq_event_t ev;
+    snd_seq_ev_clear(&ev);
+    long used = snd_midi_event_encode(d->encoder, message.bytes, message.length, &ev);
+    if (used > 0 && ev.type != SND_SEQ_EVENT_NONE) {
+        d->sendToVirtualOutput(ev);
+    }
+#endif
+}
+
+void MIDIManager::sendToVirtualOutput(const SysExMessage& message)
+{
+    if (message.isEmpty()) return;
+
+#if defined(USE_COREMIDI)
+    d->sendToVirtualOutput(message.data(), message.size());
+
+#elif defined(USE_ALSA)
+    snd_seq_event_t ev;
+    snd_seq_ev_clear(&ev);
+    snd_seq_ev_set_sysex(&ev, message.size(), const_cast<uint8_t*>(message.data()));
+    d->sendToVirtualOutput(ev);
+#endif
+}
+
+void MIDIManager::setForwardTarget(SerialManager* serial)
+{
+    d->forwardTarget.store(serial, std::memory_order_release);
+}
+
 void MIDIManager::setForwardingEnabled(bool enabled)
 {
-    m_forwardingEnabled = enabled;
+    d->forwardingEnabled.store(enabled, std::memory_order_relaxed);
 }
 
 bool MIDIManager::isForwardingEnabled() const
 {
-    return m_forwardingEnabled;
+    return d->forwardingEnabled.load(std::memory_order_relaxed);
+}
+
+void MIDIManager::setRoutingRules(const std::vector<RouteRule>& rules)
+{
+    std::vector<MidiMessage> released;
+    d->router.setRules(rules, &released);
+
+    // Notes held under the old rules are stopped where they were started
+    SerialManager* serial = d->forwardTarget.load(std::memory_order_acquire);
+    if (serial && serial->isConnected()) {
+        for (const MidiMessage& noteOff : released) {
+            serial->sendMidi(noteOff);
+        }
+    }
+}
+
+std::vector<RouteRule> MIDIManager::routingRules() const
+{
+    return d->router.rules();
+}
+
+void MIDIManager::setVoiceAllocation(const VoiceAllocator::Config& config)
+{
+    VoiceAllocator::Output out[VoiceAllocator::MAX_OUTPUTS];
+    int released = d->voices.setConfig(config, out);
+
+    // Voices still held under the old config are released on the device
+    SerialManager* serial = d->forwardTarget.load(std::memory_order_acquire);
+    if (serial && serial->isConnected()) {
+        for (int i = 0; i < released; i++) {
+            serial->sendMidi(out[i].message);
+        }
+    }
+}
+
+VoiceAllocator::Config MIDIManager::voiceAllocation() const
+{
+    return d->voices.config();
+}
+
+void MIDIManager::invalidateVoicePatches()
+{
+    d->voices.invalidatePatches();
+}
+
+quint64 MIDIManager::receivedCount() const
+{
+    return d->receivedCount.load(std::memory_order_relaxed);
+}
+
+quint64 MIDIManager::forwardedCount() const
+{
+    return d->forwardedCount.load(std::memory_order_relaxed);
 }
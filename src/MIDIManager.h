@@ -2,13 +2,18 @@
 #define MIDIMANAGER_H
 
 #include <QObject>
+#include <QList>
 #include <QStringList>
 #include <vector>
 #include <memory>
 #include "Types.h"
+#include "MidiMessage.h"
+#include "MidiRouter.h"
+#include "VoiceAllocator.h"
 
 // Forward declarations for platform-specific implementation
 class MIDIManagerPrivate;
+class SerialManager;
 
 /**
  * Cross-platform MIDI input manager.
@@ -17,6 +22,15 @@ class MIDIManagerPrivate;
  * - macOS: CoreMIDI with native virtual port creation
  * - Linux: ALSA with native virtual port creation
  * - Windows: RtMidi or WinMM (requires loopMIDI for virtual ports)
+ *
+ * Input is forwarded to the serial target directly from the backend's
+ * MIDI thread, so the GUI thread never sits in the note path. The UI
+ * samples receivedCount()/forwardedCount() for activity display instead.
+ *
+ * Up to MAX_INPUTS ports can be open at once and are merged into one
+ * stream. Every message carries the source ID returned by openInputPort()
+ * and an arrival timestamp on a clock shared by all sources, and each
+ * source keeps its own event, byte and drop counters.
  */
 class MIDIManager : public QObject
 {
@@ -30,12 +44,29 @@ public:
     QStringList availableInputPorts() const;
     void refreshPorts();
 
-    // Port connection
-    bool openInputPort(int portIndex);
-    bool openInputPort(const QString& portName);
-    void closeInputPort();
+    static constexpr int MAX_INPUTS = 8;
+    static constexpr int DIRECT_SOURCE = MAX_INPUTS;  // ALSA senders we didn't subscribe to
+
+    struct InputStats {
+        quint64 events = 0;
+        quint64 bytes = 0;
+        quint64 drops = 0;      // Malformed or oversized input, or serial TX ring full
+    };
+
+    // Port connection; returns the source ID, or -1 on failure. Opening a
+    // port that is already open returns its existing ID.
+    int openInputPort(int portIndex);
+    int openInputPort(const QString& portName);
+    void closeInputPort(int sourceId);
+    void closeAllInputPorts();
+    // Close inputs whose port is no longer listed (device unplugged, DAW
+    // quit); returns how many were closed
+    int closeVanishedInputPorts();
     bool isInputOpen() const;
-    QString currentInputPort() const;
+    QList<int> openInputSources() const;
+    QString inputPortName(int sourceId) const;
+    int findInputSource(const QString& portName) const;
+    InputStats inputStats(int sourceId) const;
 
     // Virtual port creation (macOS/Linux only)
     bool canCreateVirtualPorts() const;
@@ -43,13 +74,38 @@ public:
     void destroyVirtualInputPort();
     bool hasVirtualPort() const;
 
-    // Enable/disable MIDI forwarding
+    // Virtual output (macOS/Linux only) that republishes device traffic -
+    // CC echoes, notes, patch dumps - so a DAW can record it
+    bool createVirtualOutputPort(const QString& name = "Genesis Engine Out");
+    void destroyVirtualOutputPort();
+    bool hasVirtualOutputPort() const;
+
+    // Thread-safe; called from the serial transport thread. No-op while no
+    // virtual output exists.
+    void sendToVirtualOutput(const MidiMessage& message);
+    void sendToVirtualOutput(const SysExMessage& message);
+
+    // MIDI forwarding (thread-safe; called from the MIDI input thread path)
+    void setForwardTarget(SerialManager* serial);
     void setForwardingEnabled(bool enabled);
     bool isForwardingEnabled() const;
 
+    // Channel remap / split / layer rules applied to forwarded notes
+    void setRoutingRules(const std::vector<RouteRule>& rules);
+    std::vector<RouteRule> routingRules() const;
+
+    // Host-side poly: spreads one input channel across the FM channels
+    void setVoiceAllocation(const VoiceAllocator::Config& config);
+    VoiceAllocator::Config voiceAllocation() const;
+    void invalidateVoicePatches();      // Call after loading patches outside the allocator
+
+    // Activity counters, sampled by the UI
+    quint64 receivedCount() const;
+    quint64 forwardedCount() const;
+
 signals:
     // Raw MIDI data received (for forwarding to serial)
-    void midiReceived(const std::vector<uint8_t>& message);
+    void midiReceived(const MidiMessage& message);
 
     // Parsed MIDI events (for UI display)
     void noteOnReceived(uint8_t channel, uint8_t note, uint8_t velocity);
@@ -57,17 +113,20 @@ signals:
     void controlChangeReceived(uint8_t channel, uint8_t cc, uint8_t value);
     void programChangeReceived(uint8_t channel, uint8_t program);
     void pitchBendReceived(uint8_t channel, uint16_t value);
-    void sysExReceived(const std::vector<uint8_t>& data);
+    void sysExReceived(const SysExMessage& message);
+
+    // Forwarding replaced the patch on an FM channel (a program change, or
+    // a voice-allocation recall); emitted from the input thread
+    void channelPatchChanged(int channel);
 
     // Status
     void portsChanged();
-    void inputOpened(const QString& portName);
-    void inputClosed();
+    void inputOpened(int sourceId, const QString& portName);
+    void inputClosed(int sourceId);
     void error(const QString& message);
 
 private:
     std::unique_ptr<MIDIManagerPrivate> d;
-    bool m_forwardingEnabled;
 };
 
 #endif // MIDIMANAGER_H
@@ -24,6 +24,13 @@
 #include <QCloseEvent>
 #include <QApplication>
 #include <QRandomGenerator>
+#include <QInputDialog>
+#include <QSignalBlocker>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QFile>
+#include <QPushButton>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
@@ -32,6 +39,8 @@ MainWindow::MainWindow(QWidget* parent)
     , m_patchBank(new PatchBank(this))
     , m_midiRxTimer(new QTimer(this))
     , m_midiTxTimer(new QTimer(this))
+    , m_midiActivityTimer(new QTimer(this))
+    , m_midiPortPollTimer(new QTimer(this))
 {
     setWindowTitle("Genesis Engine Synth");
     setMinimumSize(1000, 700);
@@ -42,6 +51,12 @@ MainWindow::MainWindow(QWidget* parent)
     m_midiTxTimer->setSingleShot(true);
     m_midiTxTimer->setInterval(100);
 
+    // MIDI input is forwarded off the GUI thread; the LEDs just sample it
+    m_midi->setForwardTarget(m_serial);
+    m_serial->setEchoTarget(m_midi);
+    m_midiActivityTimer->setInterval(MIDI_ACTIVITY_SAMPLE_MS);
+    m_midiPortPollTimer->setInterval(MIDI_PORT_POLL_MS);
+
     setupUI();
     setupMenus();
     setupConnections();
@@ -57,6 +72,18 @@ MainWindow::MainWindow(QWidget* parent)
 MainWindow::~MainWindow()
 {
     saveSettings();
+
+    // MIDI input threads forward straight into m_serial, so shut them down
+    // before child cleanup destroys the serial manager
+    m_midiActivityTimer->stop();
+    m_midiPortPollTimer->stop();
+    m_serial->setEchoTarget(nullptr);
+
+    // The serial manager is destroyed as a child after this body has run,
+    // and its disconnect() can still emit (aborted upload or calibration)
+    QObject::disconnect(m_serial, nullptr, this, nullptr);
+    delete m_midi;
+    m_midi = nullptr;
 }
 
 void MainWindow::setupUI()
@@ -95,15 +122,29 @@ void MainWindow::setupUI()
     m_boardInfoLabel->hide();
     connLayout->addWidget(m_boardInfoLabel);
 
+    // Link health (hidden until the first health ping comes back)
+    m_linkHealthLabel = new QLabel();
+    m_linkHealthLabel->setStyleSheet("color: #888; font-size: 11px;");
+    m_linkHealthLabel->hide();
+    connLayout->addWidget(m_linkHealthLabel);
+
+    // Device telemetry (hidden until the device reports)
+    m_telemetryLabel = new QLabel();
+    m_telemetryLabel->setStyleSheet("color: #888; font-size: 11px;");
+    m_telemetryLabel->hide();
+    connLayout->addWidget(m_telemetryLabel);
+
     leftLayout->addWidget(connectionGroup);
 
     // MIDI group
     QGroupBox* midiGroup = new QGroupBox("MIDI Input");
     QVBoxLayout* midiLayout = new QVBoxLayout(midiGroup);
 
-    m_midiPortCombo = new QComboBox();
-    m_midiPortCombo->addItem("(None)");
-    midiLayout->addWidget(m_midiPortCombo);
+    // Every checked port is opened; their input is merged
+    m_midiPortList = new QListWidget();
+    m_midiPortList->setMaximumHeight(90);
+    m_midiPortList->setToolTip("Check each MIDI input to merge into the device stream");
+    midiLayout->addWidget(m_midiPortList);
 
     QHBoxLayout* midiRow = new QHBoxLayout();
     m_virtualMidiButton = new QPushButton("Create Virtual Port");
@@ -176,6 +217,11 @@ void MainWindow::setupUI()
     m_randomizeButton->setToolTip("Generate a random FM patch with sensible constraints");
     fmBankLayout->addWidget(m_randomizeButton);
 
+    // Bank upload button
+    m_uploadBankButton = new QPushButton("Upload Bank to Device");
+    m_uploadBankButton->setToolTip("Store all 16 FM patches to the device's slots with acknowledged transfer");
+    fmBankLayout->addWidget(m_uploadBankButton);
+
     // Target selection
     QHBoxLayout* targetRow = new QHBoxLayout();
     targetRow->addWidget(new QLabel("Channel:"));
@@ -274,7 +320,7 @@ void MainWindow::setupUI()
 
     // Panic button
     m_panicButton = new QPushButton("PANIC");
-    m_panicButton->setToolTip("Send All Notes Off to all channels (stops stuck notes)");
+    m_panicButton->setToolTip("Send note-off for every note the device is holding (stops stuck notes)");
     m_panicButton->setStyleSheet(
         "QPushButton { background-color: #600; color: #fff; font-weight: bold; padding: 4px 12px; }"
         "QPushButton:hover { background-color: #800; }"
@@ -314,6 +360,24 @@ void MainWindow::setupMenus()
     QAction* quitAction = fileMenu->addAction("&Quit", this, &QWidget::close);
     quitAction->setShortcut(QKeySequence::Quit);
 
+    // MIDI menu
+    QMenu* midiMenu = menuBar()->addMenu("&MIDI");
+    midiMenu->addAction("&Routing Rules...", this, &MainWindow::onEditRoutingRules);
+    midiMenu->addAction("&Voice Allocation...", this, &MainWindow::onEditVoiceAllocation);
+    midiMenu->addAction("Stuck Note &Watchdog...", this, &MainWindow::onEditStuckNoteWatchdog);
+    midiMenu->addSeparator();
+    midiMenu->addAction("Calibrate &Latency...", this, &MainWindow::onCalibrateLatency);
+    m_linkHealthAction = midiMenu->addAction("Link &Health Monitor");
+    m_linkHealthAction->setCheckable(true);
+    midiMenu->addAction("Device &Telemetry...", this, &MainWindow::onEditTelemetryInterval);
+    connect(m_linkHealthAction, &QAction::toggled, this, [this](bool enabled) {
+        m_serial->setLinkHealthMonitor(enabled, m_serial->linkHealthInterval());
+        if (!enabled) {
+            m_linkDegraded = false;
+            m_linkHealthLabel->hide();
+        }
+    });
+
     // Help menu
     QMenu* helpMenu = menuBar()->addMenu("&Help");
     helpMenu->addAction("&About", this, [this]() {
@@ -334,13 +398,32 @@ void MainWindow::setupConnections()
     connect(m_serial, &SerialManager::disconnected, this, &MainWindow::onSerialDisconnected);
     connect(m_serial, &SerialManager::connectionError, this, &MainWindow::onSerialError);
     connect(m_serial, &SerialManager::boardTypeDetected, this, &MainWindow::onBoardTypeDetected);
-    connect(m_serial, &SerialManager::ccReceived, this, &MainWindow::onCCReceived);
+    connect(m_serial, &SerialManager::midiEventsReceived, this, &MainWindow::onSerialMidiReceived);
+    connect(m_serial, &SerialManager::baudRateChanged, this, [this](int baudRate) {
+        statusBar()->showMessage(QString("Serial link: %1 baud").arg(baudRate), 3000);
+    });
+    connect(m_serial, &SerialManager::calibrationProgress, this, [this](int done, int total) {
+        statusBar()->showMessage(QString("Calibrating latency... %1/%2").arg(done).arg(total));
+    });
+    connect(m_serial, &SerialManager::calibrationFinished,
+            this, &MainWindow::showLatencyCalibration);
+    connect(m_serial, &SerialManager::linkHealthChanged, this, &MainWindow::showLinkHealth);
+    connect(m_serial, &SerialManager::telemetryReceived, this, &MainWindow::showDeviceTelemetry);
 
     // MIDI connections
-    connect(m_midiPortCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
-            this, &MainWindow::onMIDIPortChanged);
+    connect(m_midiPortList, &QListWidget::itemChanged, this, &MainWindow::onMIDIPortToggled);
     connect(m_virtualMidiButton, &QPushButton::clicked, this, &MainWindow::onCreateVirtualPort);
-    connect(m_midi, &MIDIManager::midiReceived, this, &MainWindow::onMIDIReceived);
+    connect(m_midiActivityTimer, &QTimer::timeout, this, &MainWindow::onMidiActivitySample);
+    m_midiActivityTimer->start();
+    connect(m_midiPortPollTimer, &QTimer::timeout, this, &MainWindow::onMidiPortPoll);
+    m_midiPortPollTimer->start();
+    connect(m_midi, &MIDIManager::inputClosed, m_serial, &SerialManager::notifyInputClosed);
+    // Live-edit deltas assume the target channel still holds the editor's patch
+    connect(m_midi, &MIDIManager::channelPatchChanged, this, [this](int channel) {
+        if (channel == m_liveSyncedChannel) {
+            m_liveSyncedChannel = -1;
+        }
+    });
     connect(m_midiForwardCheck, &QCheckBox::toggled, m_midi, &MIDIManager::setForwardingEnabled);
 
     // Patch bank connections
@@ -350,9 +433,14 @@ void MainWindow::setupConnections()
     connect(m_savePatchButton, &QPushButton::clicked, this, &MainWindow::onSavePatchClicked);
     connect(m_sendPatchButton, &QPushButton::clicked, this, &MainWindow::onSendPatchClicked);
     connect(m_randomizeButton, &QPushButton::clicked, this, &MainWindow::onRandomizePatchClicked);
+    connect(m_uploadBankButton, &QPushButton::clicked, this, &MainWindow::onUploadBankClicked);
+    connect(m_serial, &SerialManager::bankUploadProgress, this, &MainWindow::onBankUploadProgress);
+    connect(m_serial, &SerialManager::bankUploadFinished, this, &MainWindow::onBankUploadFinished);
 
     // Editor connections
     connect(m_fmEditor, &FMPatchEditor::patchChanged, this, &MainWindow::onPatchEdited);
+    connect(m_fmEditor, &FMPatchEditor::parameterChanged, this, &MainWindow::onPatchParameterEdited);
+    connect(m_liveEditCheck, &QCheckBox::toggled, this, [this]() { m_liveSyncedChannel = -1; });
 
     // Mode
     connect(m_modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -392,17 +480,15 @@ void MainWindow::refreshSerialPorts()
 
 void MainWindow::refreshMIDIPorts()
 {
-    QString currentPort = m_midiPortCombo->currentText();
-    m_midiPortCombo->clear();
-    m_midiPortCombo->addItem("(None)");
-
-    QStringList ports = m_midi->availableInputPorts();
-    m_midiPortCombo->addItems(ports);
-
-    // Try to restore previous selection
-    int idx = m_midiPortCombo->findText(currentPort);
-    if (idx >= 0) {
-        m_midiPortCombo->setCurrentIndex(idx);
+    QSignalBlocker blocker(m_midiPortList);
+    m_midiPortList->clear();
+
+    // Open inputs stay checked across refreshes
+    const QStringList ports = m_midi->availableInputPorts();
+    for (const QString& port : ports) {
+        QListWidgetItem* item = new QListWidgetItem(port, m_midiPortList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(m_midi->findInputSource(port) >= 0 ? Qt::Checked : Qt::Unchecked);
     }
 }
 
@@ -460,6 +546,8 @@ void MainWindow::onRefreshPortsClicked()
 
 void MainWindow::onSerialConnected()
 {
+    m_liveSyncedChannel = -1;
+    m_midi->invalidateVoicePatches();
     updateConnectionStatus();
     statusBar()->showMessage("Connected to device", 3000);
 }
@@ -468,6 +556,9 @@ void MainWindow::onSerialDisconnected()
 {
     updateConnectionStatus();
     m_boardInfoLabel->hide();
+    m_linkHealthLabel->hide();
+    m_linkDegraded = false;
+    m_telemetryLabel->hide();
     m_virtualMidiButton->setVisible(true);  // Show again for next connection
     statusBar()->showMessage("Disconnected from device", 3000);
 }
@@ -522,113 +613,139 @@ void MainWindow::onBoardTypeDetected(BoardType type)
     m_boardInfoLabel->show();
 }
 
-void MainWindow::onCCReceived(uint8_t channel, uint8_t cc, uint8_t value)
+void MainWindow::onSerialMidiReceived(const std::vector<MidiMessage>& events)
 {
     // Flash RX LED to show we received something
-    m_midiRxLed->setStyleSheet("background-color: #0f0; color: #000; border: 1px solid #0a0; border-radius: 3px; font-size: 10px;");
-    m_midiRxTimer->start();
+    flashMidiRxLed();
 
-    // Only update UI if this CC is for the currently selected channel
+    // Only update UI for CCs on the currently selected channel. Echo bursts
+    // repeat the same controllers, so keep just the newest value of each.
     uint8_t selectedChannel = m_targetChannel->value() - 1;
-    if (channel != selectedChannel) return;
+    std::array<int, 128> latest;
+    latest.fill(-1);
+    bool anyCC = false;
+    for (const MidiMessage& event : events) {
+        if (event.type() == 0xB0 && event.channel() == selectedChannel) {
+            latest[event.data1()] = event.data2();
+            anyCC = true;
+        }
+    }
+    if (!anyCC) return;
 
     // Set flag to prevent redundant SysEx sends when updating UI from hardware
     m_updatingFromHardware = true;
 
     // Block signals to prevent feedback loops
-    switch (cc) {
-        case 1:  // Mod wheel / LFO
-            {
-                bool lfoOn = (value > 0);
-                m_lfoEnableCheck->blockSignals(true);
-                m_lfoEnableCheck->setChecked(lfoOn);
-                m_lfoSpeedCombo->setEnabled(lfoOn);
-                m_lfoEnableCheck->blockSignals(false);
-            }
-            break;
+    if (latest[1] >= 0) {  // Mod wheel / LFO
+        bool lfoOn = (latest[1] > 0);
+        m_lfoEnableCheck->blockSignals(true);
+        m_lfoEnableCheck->setChecked(lfoOn);
+        m_lfoSpeedCombo->setEnabled(lfoOn);
+        m_lfoEnableCheck->blockSignals(false);
+    }
 
-        case 10:  // Pan
-            {
-                int panIndex;
-                if (value < 43) panIndex = 0;       // Left
-                else if (value > 85) panIndex = 2;  // Right
-                else panIndex = 1;                   // Center
-
-                m_panCombo->blockSignals(true);
-                m_panCombo->setCurrentIndex(panIndex);
-                m_panCombo->blockSignals(false);
-            }
-            break;
+    if (latest[10] >= 0) {  // Pan
+        int value = latest[10];
+        int panIndex;
+        if (value < 43) panIndex = 0;       // Left
+        else if (value > 85) panIndex = 2;  // Right
+        else panIndex = 1;                   // Center
 
-        case 14:  // Algorithm
-            if (value < 8) {
-                FMPatch patch = m_fmEditor->patch();
-                patch.algorithm = value;
-                m_fmEditor->setPatch(patch);
-            }
-            break;
+        m_panCombo->blockSignals(true);
+        m_panCombo->setCurrentIndex(panIndex);
+        m_panCombo->blockSignals(false);
+    }
 
-        case 15:  // Feedback
-            if (value < 8) {
-                FMPatch patch = m_fmEditor->patch();
-                patch.feedback = value;
-                m_fmEditor->setPatch(patch);
-            }
-            break;
+    // Patch CCs are folded into a single editor update
+    FMPatch patch = m_fmEditor->patch();
+    bool patchChanged = false;
 
-        case 16: case 17: case 18: case 19:  // Operator TLs
-            {
-                uint8_t op = cc - 16;
-                FMPatch patch = m_fmEditor->patch();
-                patch.op[op].tl = value;
-                m_fmEditor->setPatch(patch);
-            }
-            break;
+    if (latest[14] >= 0 && latest[14] < 8) {  // Algorithm
+        patch.algorithm = latest[14];
+        patchChanged = true;
+    }
+    if (latest[15] >= 0 && latest[15] < 8) {  // Feedback
+        patch.feedback = latest[15];
+        patchChanged = true;
+    }
+    for (int op = 0; op < 4; op++) {  // Operator TLs (CC 16-19)
+        if (latest[16 + op] >= 0) {
+            patch.op[op].tl = latest[16 + op];
+            patchChanged = true;
+        }
+    }
 
-        case 64:  // Sustain pedal (just for display, no UI widget currently)
-            // Could add a sustain indicator if desired
-            break;
+    if (patchChanged) {
+        m_fmEditor->setPatch(patch);
     }
 
+    // CC 64 (sustain) is display-only; no UI widget currently
+
     m_updatingFromHardware = false;
 }
 
-void MainWindow::onMIDIPortChanged(int index)
+void MainWindow::onMIDIPortToggled(QListWidgetItem* item)
 {
-    m_midi->closeInputPort();
+    QString port = item->text();
 
-    if (index > 0) {
-        // Index 0 is "(None)"
-        if (m_midi->openInputPort(index - 1)) {
-            statusBar()->showMessage("MIDI input: " + m_midi->currentInputPort(), 3000);
+    if (item->checkState() == Qt::Checked) {
+        if (m_midi->openInputPort(port) >= 0) {
+            statusBar()->showMessage("MIDI input opened: " + port, 3000);
+        } else {
+            QSignalBlocker blocker(m_midiPortList);
+            item->setCheckState(Qt::Unchecked);
         }
+    } else {
+        m_midi->closeInputPort(m_midi->findInputSource(port));
+        statusBar()->showMessage("MIDI input closed: " + port, 3000);
     }
 }
 
-void MainWindow::onMIDIReceived(const std::vector<uint8_t>& message)
+void MainWindow::updateMidiInputStats()
 {
-    // Flash RX LED
-    m_midiRxLed->setStyleSheet("background-color: #0f0; color: #000; border: 1px solid #0a0; border-radius: 3px; font-size: 10px;");
-    m_midiRxTimer->start();
+    for (int row = 0; row < m_midiPortList->count(); row++) {
+        QListWidgetItem* item = m_midiPortList->item(row);
+        int source = m_midi->findInputSource(item->text());
+        if (source < 0) {
+            item->setToolTip(QString());
+            continue;
+        }
+        MIDIManager::InputStats stats = m_midi->inputStats(source);
+        item->setToolTip(QString("Source %1: %2 events, %3 bytes, %4 dropped")
+            .arg(source).arg(stats.events).arg(stats.bytes).arg(stats.drops));
+    }
+}
 
-    if (!m_midiForwardCheck->isChecked()) return;
-    if (!m_serial->isConnected()) return;
+void MainWindow::onMidiActivitySample()
+{
+    quint64 received = m_midi->receivedCount();
+    quint64 forwarded = m_midi->forwardedCount();
 
-    // Forward MIDI to serial and flash TX LED
-    m_serial->sendRawMIDI(message);
-    flashMidiTxLed();
+    if (received != m_lastMidiReceived) {
+        m_lastMidiReceived = received;
+        flashMidiRxLed();
+        updateMidiInputStats();
+    }
+    if (forwarded != m_lastMidiForwarded) {
+        m_lastMidiForwarded = forwarded;
+        flashMidiTxLed();
+    }
 }
 
 void MainWindow::onCreateVirtualPort()
 {
     if (m_midi->hasVirtualPort()) {
         m_midi->destroyVirtualInputPort();
+        m_midi->destroyVirtualOutputPort();
+        m_serial->notifyInputClosed(MIDIManager::DIRECT_SOURCE);
         m_virtualMidiButton->setText("Create Virtual Port");
-        statusBar()->showMessage("Virtual MIDI port destroyed", 3000);
+        statusBar()->showMessage("Virtual MIDI ports destroyed", 3000);
     } else {
         if (m_midi->createVirtualInputPort("Genesis Engine")) {
+            // Device traffic (CC echoes, patch dumps) goes back out here
+            m_midi->createVirtualOutputPort("Genesis Engine Out");
             m_virtualMidiButton->setText("Destroy Virtual Port");
-            statusBar()->showMessage("Virtual MIDI port created: Genesis Engine", 3000);
+            statusBar()->showMessage("Virtual MIDI ports created: Genesis Engine, Genesis Engine Out", 3000);
             refreshMIDIPorts();
         } else {
             QMessageBox::warning(this, "Error", "Failed to create virtual MIDI port");
@@ -636,6 +753,232 @@ void MainWindow::onCreateVirtualPort()
     }
 }
 
+void MainWindow::onMidiPortPoll()
+{
+    // Closing a vanished input also arms the stuck-note watchdog for it
+    if (m_midi->closeVanishedInputPorts() > 0) {
+        refreshMIDIPorts();
+        statusBar()->showMessage("MIDI input disconnected", 3000);
+    }
+}
+
+void MainWindow::onEditRoutingRules()
+{
+    QString current = MidiRouter::formatRules(m_midi->routingRules()).join('\n');
+    bool ok = false;
+    QString text = QInputDialog::getMultiLineText(this, "MIDI Routing Rules",
+        "One rule per line (channels are 1-based, empty = pass-through):\n"
+        "in=1 keys=0-59 out=1 transpose=12\n"
+        "in=1 keys=60-127 vel=1-100 out=2,3",
+        current, &ok);
+    if (!ok) return;
+
+    QStringList errors;
+    std::vector<RouteRule> rules = MidiRouter::parseRules(text.split('\n'), &errors);
+    if (!errors.isEmpty()) {
+        QMessageBox::warning(this, "Routing Rules", errors.join('\n'));
+        return;
+    }
+
+    m_midi->setRoutingRules(rules);
+    statusBar()->showMessage(rules.empty() ? QString("MIDI routing disabled")
+                                           : QString("MIDI routing: %1 rules").arg(rules.size()),
+                             3000);
+}
+
+void MainWindow::onEditVoiceAllocation()
+{
+    VoiceAllocator::Config config = m_midi->voiceAllocation();
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Voice Allocation");
+    QFormLayout* form = new QFormLayout(&dialog);
+
+    QCheckBox* enabledCheck = new QCheckBox("Allocate voices on the host");
+    enabledCheck->setChecked(config.enabled);
+    enabledCheck->setToolTip("Spread notes from one input channel across FM channels 1-6 "
+                             "(device stays in Multi mode)");
+    form->addRow(enabledCheck);
+
+    QSpinBox* channelSpin = new QSpinBox();
+    channelSpin->setRange(1, 16);
+    channelSpin->setValue(config.inputChannel + 1);
+    form->addRow("Input channel:", channelSpin);
+
+    QComboBox* policyCombo = new QComboBox();
+    policyCombo->addItems(VoiceAllocator::policyNames());
+    policyCombo->setCurrentIndex(static_cast<int>(config.policy));
+    form->addRow("Voice stealing:", policyCombo);
+
+    QSpinBox* slotSpin = new QSpinBox();
+    slotSpin->setRange(-1, 15);
+    slotSpin->setSpecialValueText("Unmanaged");
+    slotSpin->setValue(config.patchSlot);
+    slotSpin->setToolTip("Slot every voice should play; recalled only on channels that "
+                         "don't hold it yet. Program changes on the input channel select it.");
+    form->addRow("Patch slot:", slotSpin);
+
+    QSpinBox* releaseSpin = new QSpinBox();
+    releaseSpin->setRange(0, 5000);
+    releaseSpin->setSuffix(" ms");
+    releaseSpin->setValue(config.releaseMs);
+    releaseSpin->setToolTip("How long a released note is assumed to keep ringing");
+    form->addRow("Release time:", releaseSpin);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    config.enabled = enabledCheck->isChecked();
+    config.inputChannel = channelSpin->value() - 1;
+    config.policy = static_cast<VoiceAllocator::Policy>(policyCombo->currentIndex());
+    config.patchSlot = slotSpin->value();
+    config.releaseMs = releaseSpin->value();
+    m_midi->setVoiceAllocation(config);
+
+    // Host allocation needs the device in multi-timbral mode
+    if (config.enabled && m_modeCombo->currentIndex() != 0) {
+        m_modeCombo->setCurrentIndex(0);
+    }
+    statusBar()->showMessage(config.enabled
+        ? QString("Host voice allocation on channel %1 (%2)")
+              .arg(config.inputChannel + 1).arg(VoiceAllocator::policyName(config.policy))
+        : QString("Host voice allocation disabled"), 3000);
+}
+
+void MainWindow::onEditStuckNoteWatchdog()
+{
+    bool ok = false;
+    int limitMs = QInputDialog::getInt(this, "Stuck Note Watchdog",
+        "Release notes still held this many ms after their MIDI input closed (0 = off):",
+        m_serial->stuckNoteLimit(), 0, 60000, 100, &ok);
+    if (!ok) return;
+
+    m_serial->setStuckNoteLimit(limitMs);
+    statusBar()->showMessage(limitMs > 0
+        ? QString("Stuck note watchdog: %1 ms").arg(limitMs)
+        : QString("Stuck note watchdog disabled"), 3000);
+}
+
+void MainWindow::onCalibrateLatency()
+{
+    if (!m_serial->isConnected()) {
+        statusBar()->showMessage("Not connected - cannot calibrate", 3000);
+        return;
+    }
+    if (!m_serial->startLatencyCalibration()) {
+        QMessageBox::information(this, "Latency Calibration",
+            "The serial link is busy (bank upload, baud negotiation or a calibration "
+            "already running). Try again in a moment.");
+        return;
+    }
+    statusBar()->showMessage("Calibrating latency...");
+}
+
+void MainWindow::showLatencyCalibration(const LatencyCalibration& result)
+{
+    if (!result.valid) {
+        statusBar()->showMessage("Latency calibration failed", 3000);
+        QMessageBox::warning(this, "Latency Calibration",
+            QString("Calibration failed: %1 of %2 pings answered.")
+                .arg(result.samples).arg(result.samples + result.lost));
+        return;
+    }
+
+    auto ms = [](double us) { return QString::number(us / 1000.0, 'f', 2); };
+    statusBar()->showMessage(QString("Latency: %1 ms one-way").arg(ms(result.oneWayUs)), 5000);
+
+    QMessageBox box(this);
+    box.setWindowTitle("Latency Calibration");
+    box.setText(QString("One-way latency: %1 ms (jitter %2 ms)\n"
+                        "Round trip: min %3, median %4, max %5 ms\n"
+                        "%6 pings answered, %7 lost\n\n"
+                        "Set the DAW track delay to -%1 ms for MIDI played through the app.%8")
+        .arg(ms(result.oneWayUs), ms(result.jitterUs), ms(result.rttMinUs),
+             ms(result.rttMedianUs), ms(result.rttMaxUs))
+        .arg(result.samples).arg(result.lost)
+        .arg(m_serial->latencyCompensation()
+             ? QString("\nScheduled output is now sent this much early.") : QString()));
+    QPushButton* exportButton = box.addButton("Export...", QMessageBox::ActionRole);
+    box.addButton(QMessageBox::Close);
+    box.exec();
+    if (box.clickedButton() != exportButton) return;
+
+    QString filePath = QFileDialog::getSaveFileName(
+        this, "Export Latency Calibration", "genesis-engine-latency.txt",
+        "Text Files (*.txt);;All Files (*)");
+    if (filePath.isEmpty()) return;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, "Error", "Failed to write " + filePath);
+        return;
+    }
+    file.write(result.toText().toUtf8());
+    statusBar()->showMessage("Latency calibration exported: " + filePath, 3000);
+}
+
+void MainWindow::showLinkHealth(const LinkHealth& health)
+{
+    if (!health.monitoring) return;
+
+    if (health.samples > 0) {
+        auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 1); };
+        m_linkHealthLabel->setText(QString("Link: %1 ms typical, %2 ms p99, %3 lost")
+            .arg(ms(health.rttP50Us), ms(health.rttP99Us)).arg(health.pingsLost));
+    } else {
+        m_linkHealthLabel->setText(QString("Link: no replies yet, %1 lost").arg(health.pingsLost));
+    }
+    m_linkHealthLabel->setToolTip(health.toText());
+    m_linkHealthLabel->setStyleSheet(health.degraded ? "color: #f66; font-size: 11px;"
+                                                     : "color: #888; font-size: 11px;");
+    m_linkHealthLabel->show();
+
+    if (health.degraded && !m_linkDegraded) {
+        statusBar()->showMessage("Serial link degraded: " + health.reason, 10000);
+    } else if (!health.degraded && m_linkDegraded) {
+        statusBar()->showMessage("Serial link recovered", 3000);
+    }
+    m_linkDegraded = health.degraded;
+}
+
+void MainWindow::onEditTelemetryInterval()
+{
+    bool ok = false;
+    int intervalMs = QInputDialog::getInt(this, "Device Telemetry",
+        "Ask the device for loop time, overrun counters and voices every this many ms (0 = off):",
+        m_serial->telemetryInterval(), 0, 60000, 100, &ok);
+    if (!ok) return;
+
+    m_serial->setTelemetryInterval(intervalMs);
+    if (m_serial->telemetryInterval() == 0) {
+        m_telemetryLabel->hide();
+    }
+    statusBar()->showMessage(intervalMs > 0
+        ? QString("Device telemetry every %1 ms").arg(m_serial->telemetryInterval())
+        : QString("Device telemetry disabled"), 3000);
+}
+
+void MainWindow::showDeviceTelemetry(const DeviceTelemetry& telemetry)
+{
+    const bool overrun = telemetry.rxOverflowsDelta > 0 || telemetry.sysexDroppedDelta > 0;
+    m_telemetryLabel->setText(QString("Device: loop %1/%2 us, %3 FM + %4 PSG, %5 overruns")
+        .arg(telemetry.loopAvgUs).arg(telemetry.loopMaxUs)
+        .arg(telemetry.fmVoices).arg(telemetry.psgVoices)
+        .arg(telemetry.rxOverflows + telemetry.sysexDropped));
+    m_telemetryLabel->setToolTip(telemetry.toText());
+    m_telemetryLabel->setStyleSheet(overrun ? "color: #f66; font-size: 11px;"
+                                            : "color: #888; font-size: 11px;");
+    m_telemetryLabel->show();
+
+    if (overrun) {
+        statusBar()->showMessage("Device overrun: " + telemetry.toText(), 5000);
+    }
+}
+
 void MainWindow::onFMPatchSelected(int row)
 {
     if (row < 0 || row >= PatchBank::FM_SLOT_COUNT) return;
@@ -643,6 +986,7 @@ void MainWindow::onFMPatchSelected(int row)
     m_selectedFMSlot = row;
     m_targetSlot->setValue(row);
     m_fmEditor->setPatch(m_patchBank->fmPatch(row));
+    m_liveSyncedChannel = -1;
 }
 
 void MainWindow::onPSGEnvelopeSelected(int row)
@@ -665,6 +1009,7 @@ void MainWindow::onLoadPatchClicked()
         m_patchBank->setFMPatch(m_selectedFMSlot, *patch);
         updatePatchList();
         m_fmEditor->setPatch(*patch);
+        m_liveSyncedChannel = -1;
         statusBar()->showMessage("Loaded patch: " + patch->name, 3000);
     } else {
         QMessageBox::warning(this, "Error", "Failed to load patch file");
@@ -704,17 +1049,59 @@ void MainWindow::onSendPatchClicked()
     // Send to both slot and channel
     m_serial->sendFMPatchToSlot(slot, patch);
     m_serial->sendFMPatchToChannel(channel, patch);
+    m_midi->invalidateVoicePatches();
     flashMidiTxLed();
 
     statusBar()->showMessage(QString("Sent patch to channel %1 and slot %2")
         .arg(channel + 1).arg(slot), 3000);
 }
 
+void MainWindow::onUploadBankClicked()
+{
+    if (!m_serial->isConnected()) {
+        QMessageBox::warning(this, "Not Connected", "Please connect to a device first.");
+        return;
+    }
+
+    std::vector<FMPatch> patches;
+    patches.reserve(PatchBank::FM_SLOT_COUNT);
+    for (int slot = 0; slot < PatchBank::FM_SLOT_COUNT; slot++) {
+        patches.push_back(m_patchBank->fmPatch(slot));
+    }
+
+    if (m_serial->uploadBank(patches)) {
+        m_uploadBankButton->setEnabled(false);
+        statusBar()->showMessage("Uploading bank...");
+    }
+}
+
+void MainWindow::onBankUploadProgress(int slotsDone, int slotsTotal)
+{
+    statusBar()->showMessage(QString("Uploading bank... %1/%2").arg(slotsDone).arg(slotsTotal));
+    flashMidiTxLed();
+}
+
+void MainWindow::onBankUploadFinished(bool success, int slotsStored, int slotsUnverified,
+                                      double bytesPerSecond)
+{
+    m_uploadBankButton->setEnabled(true);
+    m_midi->invalidateVoicePatches();   // Slot contents changed
+
+    if (slotsUnverified > 0) {
+        statusBar()->showMessage(QString("Bank sent: %1 slots at %2 bytes/s, not confirmed "
+                                         "(firmware doesn't acknowledge uploads)")
+            .arg(slotsUnverified).arg(qRound(bytesPerSecond)), 8000);
+    } else if (success) {
+        statusBar()->showMessage(QString("Bank uploaded: %1 slots at %2 bytes/s")
+            .arg(slotsStored).arg(qRound(bytesPerSecond)), 5000);
+    } else {
+        statusBar()->showMessage(QString("Bank upload failed after %1 slots").arg(slotsStored), 5000);
+    }
+}
+
 void MainWindow::onPatchEdited()
 {
-    FMPatch patch = m_fmEditor->patch();
-    patch.name = m_patchBank->fmPatch(m_selectedFMSlot).name;  // Preserve name
-    m_patchBank->setFMPatch(m_selectedFMSlot, patch);
+    storeEditedPatch();
 
     // Live edit: auto-send to device (skip if updating from hardware CC echo)
     if (m_liveEditCheck->isChecked() && !m_updatingFromHardware) {
@@ -722,6 +1109,23 @@ void MainWindow::onPatchEdited()
     }
 }
 
+void MainWindow::onPatchParameterEdited(int opIndex, FMParam param, uint8_t value)
+{
+    storeEditedPatch();
+
+    // Live edit: send just the changed parameter
+    if (m_liveEditCheck->isChecked() && !m_updatingFromHardware) {
+        sendLiveParameter(opIndex, param, value);
+    }
+}
+
+void MainWindow::storeEditedPatch()
+{
+    FMPatch patch = m_fmEditor->patch();
+    patch.name = m_patchBank->fmPatch(m_selectedFMSlot).name;  // Preserve name
+    m_patchBank->setFMPatch(m_selectedFMSlot, patch);
+}
+
 void MainWindow::onModeChanged(int index)
 {
     if (!m_serial->isConnected()) return;
@@ -793,12 +1197,10 @@ void MainWindow::onKeyboardNoteOn(int note, int velocity)
 
     // Send Note On on channel 1 (0x90)
     uint8_t channel = m_targetChannel->value() - 1;
-    std::vector<uint8_t> msg = {
+    m_serial->sendMidi(MidiMessage::make(
         static_cast<uint8_t>(0x90 | channel),
         static_cast<uint8_t>(note),
-        static_cast<uint8_t>(velocity)
-    };
-    m_serial->sendRawMIDI(msg);
+        static_cast<uint8_t>(velocity)));
     flashMidiTxLed();
 }
 
@@ -808,12 +1210,10 @@ void MainWindow::onKeyboardNoteOff(int note)
 
     // Send Note Off on channel 1 (0x80)
     uint8_t channel = m_targetChannel->value() - 1;
-    std::vector<uint8_t> msg = {
+    m_serial->sendMidi(MidiMessage::make(
         static_cast<uint8_t>(0x80 | channel),
         static_cast<uint8_t>(note),
-        static_cast<uint8_t>(0)
-    };
-    m_serial->sendRawMIDI(msg);
+        static_cast<uint8_t>(0)));
     flashMidiTxLed();
 }
 
@@ -824,16 +1224,13 @@ void MainWindow::onPanicClicked()
         return;
     }
 
-    // Send All Notes Off (CC 123) and All Sound Off (CC 120) on all 16 channels
-    for (uint8_t ch = 0; ch < 16; ch++) {
-        // All Sound Off (CC 120) - immediately silences all sound
-        m_serial->sendControlChange(ch, 120, 0);
-        // All Notes Off (CC 123) - releases all held notes
-        m_serial->sendControlChange(ch, 123, 0);
-    }
+    // Note-offs only for notes the device is actually holding
+    int released = m_serial->panic();
+    // Patch recalls queued with dropped note-ons never reached the device
+    m_midi->invalidateVoicePatches();
 
     flashMidiTxLed();
-    statusBar()->showMessage("Panic sent - all notes off", 2000);
+    statusBar()->showMessage(QString("Panic sent - %1 notes released").arg(released), 2000);
 }
 
 void MainWindow::onRandomizePatchClicked()
@@ -1035,16 +1432,46 @@ void MainWindow::loadSettings()
         }
     }
 
-    QString lastMidiPort = settings.value("lastMidiPort").toString();
-    if (!lastMidiPort.isEmpty()) {
-        int idx = m_midiPortCombo->findText(lastMidiPort, Qt::MatchContains);
-        if (idx >= 0) {
-            m_midiPortCombo->setCurrentIndex(idx);
+    // Reopen the previous inputs (older versions stored a single port);
+    // refreshMIDIPorts() then shows them checked
+    QStringList midiInputs = settings.value("midiInputs").toStringList();
+    if (midiInputs.isEmpty() && settings.contains("lastMidiPort")) {
+        midiInputs << settings.value("lastMidiPort").toString();
+    }
+    for (const QString& port : midiInputs) {
+        if (!port.isEmpty()) {
+            m_midi->openInputPort(port);
         }
     }
 
     // Restore Live Edit state
     m_liveEditCheck->setChecked(settings.value("liveEdit", false).toBool());
+
+    // Serial TX coalescing (advanced, no UI)
+    m_serial->setWriteCoalescing(settings.value("serial/flushBytes", 64).toInt(),
+                                 settings.value("serial/maxLatencyMs", 0).toInt());
+    m_serial->setRunningStatusEnabled(settings.value("serial/runningStatus", false).toBool());
+    m_serial->setLiveEditMaxRate(settings.value("serial/liveEditMaxRateHz", 50).toInt());
+    m_serial->setControllerThinning(settings.value("serial/controllerThinning", false).toBool(),
+                                    settings.value("serial/controllerMaxRateHz", 200).toInt());
+    m_serial->setStuckNoteLimit(settings.value("midi/stuckNoteLimitMs", 0).toInt());
+    m_serial->setLatencyCompensation(settings.value("serial/latencyCompensation", true).toBool());
+    m_serial->setLinkHealthMonitor(false, settings.value("serial/linkHealthIntervalMs", 1000).toInt());
+    m_linkHealthAction->setChecked(settings.value("serial/linkHealthMonitor", false).toBool());
+    m_serial->setTelemetryInterval(settings.value("serial/telemetryIntervalMs", 0).toInt());
+
+    // MIDI routing rules (text form, one per entry)
+    m_midi->setRoutingRules(MidiRouter::parseRules(settings.value("routing/rules").toStringList()));
+
+    // Host-side voice allocation
+    VoiceAllocator::Config voices;
+    voices.enabled = settings.value("voices/enabled", false).toBool();
+    voices.inputChannel = settings.value("voices/inputChannel", 0).toInt();
+    voices.policy = static_cast<VoiceAllocator::Policy>(
+        qBound(0, settings.value("voices/policy", 0).toInt(), 3));
+    voices.patchSlot = settings.value("voices/patchSlot", -1).toInt();
+    voices.releaseMs = settings.value("voices/releaseMs", 300).toInt();
+    m_midi->setVoiceAllocation(voices);
 }
 
 void MainWindow::saveSettings()
@@ -1054,8 +1481,26 @@ void MainWindow::saveSettings()
     settings.setValue("geometry", saveGeometry());
     settings.setValue("windowState", saveState());
     settings.setValue("lastSerialPort", m_serialPortCombo->currentText());
-    settings.setValue("lastMidiPort", m_midiPortCombo->currentText());
+    QStringList midiInputs;
+    for (int source : m_midi->openInputSources()) {
+        midiInputs << m_midi->inputPortName(source);
+    }
+    settings.setValue("midiInputs", midiInputs);
+    settings.remove("lastMidiPort");
     settings.setValue("liveEdit", m_liveEditCheck->isChecked());
+    settings.setValue("routing/rules", MidiRouter::formatRules(m_midi->routingRules()));
+
+    VoiceAllocator::Config voices = m_midi->voiceAllocation();
+    settings.setValue("voices/enabled", voices.enabled);
+    settings.setValue("voices/inputChannel", voices.inputChannel);
+    settings.setValue("voices/policy", static_cast<int>(voices.policy));
+    settings.setValue("voices/patchSlot", voices.patchSlot);
+    settings.setValue("voices/releaseMs", voices.releaseMs);
+    settings.setValue("midi/stuckNoteLimitMs", m_serial->stuckNoteLimit());
+    settings.setValue("serial/latencyCompensation", m_serial->latencyCompensation());
+    settings.setValue("serial/linkHealthMonitor", m_serial->linkHealthMonitor());
+    settings.setValue("serial/linkHealthIntervalMs", m_serial->linkHealthInterval());
+    settings.setValue("serial/telemetryIntervalMs", m_serial->telemetryInterval());
 }
 
 // =============================================================================
@@ -1072,6 +1517,12 @@ void MainWindow::onMidiTxLedTimeout()
     m_midiTxLed->setStyleSheet("background-color: #333; color: #666; border: 1px solid #555; border-radius: 3px; font-size: 10px;");
 }
 
+void MainWindow::flashMidiRxLed()
+{
+    m_midiRxLed->setStyleSheet("background-color: #0f0; color: #000; border: 1px solid #0a0; border-radius: 3px; font-size: 10px;");
+    m_midiRxTimer->start();
+}
+
 void MainWindow::flashMidiTxLed()
 {
     m_midiTxLed->setStyleSheet("background-color: #ff0; color: #000; border: 1px solid #aa0; border-radius: 3px; font-size: 10px;");
@@ -1089,7 +1540,27 @@ void MainWindow::sendLivePatch()
     const FMPatch& patch = m_patchBank->fmPatch(m_selectedFMSlot);
     uint8_t channel = m_targetChannel->value() - 1;  // Convert to 0-indexed
 
-    // Send to channel only (not slot) for live editing
-    m_serial->sendFMPatchToChannel(channel, patch);
+    // Send to channel only (not slot) for live editing; only the newest
+    // state is kept while the link is busy
+    m_serial->queueLivePatch(channel, patch);
+    m_liveSyncedChannel = channel;
+    m_midi->invalidateVoicePatches();
+    flashMidiTxLed();
+}
+
+void MainWindow::sendLiveParameter(int opIndex, FMParam param, uint8_t value)
+{
+    if (!m_serial->isConnected()) return;
+
+    uint8_t channel = m_targetChannel->value() - 1;  // Convert to 0-indexed
+
+    // A delta is only meaningful if the channel already holds this patch;
+    // otherwise sync the whole patch once (it includes this change)
+    if (channel != m_liveSyncedChannel) {
+        sendLivePatch();
+        return;
+    }
+
+    m_serial->queueLiveParameter(channel, opIndex, param, value);
     flashMidiTxLed();
 }
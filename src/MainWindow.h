@@ -10,8 +10,12 @@
 #include <QCheckBox>
 #include <QTimer>
 #include "Types.h"
+#include "MidiParser.h"
 
 class SerialManager;
+struct LatencyCalibration;
+struct LinkHealth;
+struct DeviceTelemetry;
 class MIDIManager;
 class PatchBank;
 class FMPatchEditor;
@@ -39,10 +43,16 @@ private slots:
     void onBoardTypeDetected(BoardType type);
 
     // MIDI
-    void onMIDIPortChanged(int index);
-    void onMIDIReceived(const std::vector<uint8_t>& message);
+    void onMIDIPortToggled(QListWidgetItem* item);
+    void onMidiActivitySample();
     void onCreateVirtualPort();
-    void onCCReceived(uint8_t channel, uint8_t cc, uint8_t value);
+    void onSerialMidiReceived(const std::vector<MidiMessage>& events);
+    void onEditRoutingRules();
+    void onEditVoiceAllocation();
+    void onEditStuckNoteWatchdog();
+    void onCalibrateLatency();
+    void onEditTelemetryInterval();
+    void onMidiPortPoll();
 
     // Patch bank
     void onFMPatchSelected(int row);
@@ -50,9 +60,13 @@ private slots:
     void onLoadPatchClicked();
     void onSavePatchClicked();
     void onSendPatchClicked();
+    void onUploadBankClicked();
+    void onBankUploadProgress(int slotsDone, int slotsTotal);
+    void onBankUploadFinished(bool success, int slotsStored, int slotsUnverified, double bytesPerSecond);
 
     // Patch editor
     void onPatchEdited();
+    void onPatchParameterEdited(int opIndex, FMParam param, uint8_t value);
 
     // Mode
     void onModeChanged(int index);
@@ -88,8 +102,15 @@ private:
     void updatePatchList();
     void loadSettings();
     void saveSettings();
+    void flashMidiRxLed();
     void flashMidiTxLed();
+    void updateMidiInputStats();
+    void showLatencyCalibration(const LatencyCalibration& result);
+    void showLinkHealth(const LinkHealth& health);
+    void showDeviceTelemetry(const DeviceTelemetry& telemetry);
+    void storeEditedPatch();
     void sendLivePatch();
+    void sendLiveParameter(int opIndex, FMParam param, uint8_t value);
 
     // Core managers
     SerialManager* m_serial;
@@ -102,9 +123,13 @@ private:
     QPushButton* m_refreshButton;
     QLabel* m_connectionStatus;
     QLabel* m_boardInfoLabel;
+    QLabel* m_linkHealthLabel;
+    QAction* m_linkHealthAction;
+    bool m_linkDegraded = false;
+    QLabel* m_telemetryLabel;
 
     // MIDI panel
-    QComboBox* m_midiPortCombo;
+    QListWidget* m_midiPortList;
     QPushButton* m_virtualMidiButton;
     QCheckBox* m_midiForwardCheck;
 
@@ -115,6 +140,7 @@ private:
     QPushButton* m_savePatchButton;
     QPushButton* m_sendPatchButton;
     QPushButton* m_randomizeButton;
+    QPushButton* m_uploadBankButton;
 
     // Editors
     FMPatchEditor* m_fmEditor;
@@ -144,12 +170,20 @@ private:
     QLabel* m_midiTxLed;
     QTimer* m_midiRxTimer;
     QTimer* m_midiTxTimer;
+    QTimer* m_midiActivityTimer;
+    QTimer* m_midiPortPollTimer;
+    quint64 m_lastMidiReceived = 0;
+    quint64 m_lastMidiForwarded = 0;
 
     // State
     QString m_currentBankPath;
     int m_selectedFMSlot = 0;
     int m_selectedPSGSlot = 0;
     bool m_updatingFromHardware = false;  // Prevents redundant SysEx when updating UI from CC echo
+    int m_liveSyncedChannel = -1;         // Channel known to hold the editor's patch (-1 = none)
+
+    static constexpr int MIDI_ACTIVITY_SAMPLE_MS = 33;
+    static constexpr int MIDI_PORT_POLL_MS = 2000;
 };
 
 #endif // MAINWINDOW_H
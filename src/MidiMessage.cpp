@@ -0,0 +1,150 @@
+#include "MidiMessage.h"
+#include "LockFreeQueue.h"
+
+// =============================================================================
+// SysEx Buffer Pool
+// =============================================================================
+
+namespace {
+
+// Buffers are recycled through a lock-free free list, so MIDI input threads
+// and the serial transport can acquire and release them concurrently
+class SysExPool
+{
+public:
+    SysExPool()
+    {
+        for (int i = 0; i < PREALLOCATED; i++) {
+            auto* buffer = new SysExMessage::Buffer();
+            buffer->bytes.reserve(BUFFER_RESERVE);
+            m_free.push(buffer);
+        }
+    }
+
+    ~SysExPool()
+    {
+        SysExMessage::Buffer* buffer;
+        while (m_free.pop(buffer)) {
+            delete buffer;
+        }
+    }
+
+    SysExMessage::Buffer* acquire()
+    {
+        SysExMessage::Buffer* buffer;
+        if (!m_free.pop(buffer)) {
+            // Pool exhausted - grow; the extra buffer is kept on release
+            buffer = new SysExMessage::Buffer();
+            buffer->bytes.reserve(BUFFER_RESERVE);
+        }
+        return buffer;
+    }
+
+    void release(SysExMessage::Buffer* buffer)
+    {
+        // Oversized buffers would pin memory forever
+        if (buffer->bytes.capacity() > MAX_KEPT_CAPACITY || !m_free.push(buffer)) {
+            delete buffer;
+        }
+    }
+
+private:
+    static constexpr int PREALLOCATED = 32;
+    static constexpr size_t BUFFER_RESERVE = 1024;
+    static constexpr size_t MAX_KEPT_CAPACITY = 65536;
+
+    LockFreeQueue<SysExMessage::Buffer*, 128> m_free;
+};
+
+SysExPool& pool()
+{
+    static SysExPool instance;
+    return instance;
+}
+
+} // namespace
+
+// =============================================================================
+// SysExMessage
+// =============================================================================
+
+SysExMessage SysExMessage::fromBytes(const uint8_t* data, size_t size, qint64 timestampUs)
+{
+    SysExMessage message;
+    if (size == 0) {
+        return message;
+    }
+
+    message.m_buffer = pool().acquire();
+    message.m_buffer->bytes.assign(data, data + size);
+    message.m_buffer->refs.store(1, std::memory_order_relaxed);
+    message.m_timestampUs = timestampUs;
+    return message;
+}
+
+SysExMessage::SysExMessage(const SysExMessage& other)
+    : m_buffer(other.m_buffer)
+    , m_timestampUs(other.m_timestampUs)
+    , m_source(other.m_source)
+{
+    if (m_buffer) {
+        m_buffer->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SysExMessage::SysExMessage(SysExMessage&& other) noexcept
+    : m_buffer(other.m_buffer)
+    , m_timestampUs(other.m_timestampUs)
+    , m_source(other.m_source)
+{
+    other.m_buffer = nullptr;
+}
+
+SysExMessage& SysExMessage::operator=(const SysExMessage& other)
+{
+    if (this != &other) {
+        if (other.m_buffer) {
+            other.m_buffer->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        m_buffer = other.m_buffer;
+        m_timestampUs = other.m_timestampUs;
+        m_source = other.m_source;
+    }
+    return *this;
+}
+
+SysExMessage& SysExMessage::operator=(SysExMessage&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_buffer = other.m_buffer;
+        m_timestampUs = other.m_timestampUs;
+        m_source = other.m_source;
+        other.m_buffer = nullptr;
+    }
+    return *this;
+}
+
+SysExMessage::~SysExMessage()
+{
+    release();
+}
+
+const uint8_t* SysExMessage::data() const
+{
+    return m_buffer ? m_buffer->bytes.data() : nullptr;
+}
+
+size_t SysExMessage::size() const
+{
+    return m_buffer ? m_buffer->bytes.size() : 0;
+}
+
+void SysExMessage::release()
+{
+    if (m_buffer && m_buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pool().release(m_buffer);
+    }
+    m_buffer = nullptr;
+}
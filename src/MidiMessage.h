@@ -0,0 +1,115 @@
+#ifndef MIDIMESSAGE_H
+#define MIDIMESSAGE_H
+
+#include <QMetaType>
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/**
+ * One short MIDI message (channel voice, system common or realtime) held
+ * inline, so passing it through queues and queued signals never allocates.
+ */
+struct MidiMessage {
+    static constexpr uint8_t LOCAL_SOURCE = 0xFF;   // Made in the app, not a MIDI input
+
+    uint8_t bytes[3] = {0, 0, 0};
+    uint8_t length = 0;             // Total bytes including status (0 = empty)
+    uint8_t source = LOCAL_SOURCE;  // MIDIManager input source ID
+    qint64 timestampUs = -1;        // Arrival time on the source's clock, -1 if unknown
+
+    static MidiMessage make(uint8_t status, uint8_t data1 = 0, uint8_t data2 = 0,
+                            qint64 timestampUs = -1)
+    {
+        MidiMessage message;
+        message.bytes[0] = status;
+        message.bytes[1] = data1;
+        message.bytes[2] = data2;
+        message.length = static_cast<uint8_t>(1 + dataLength(status));
+        message.timestampUs = timestampUs;
+        return message;
+    }
+
+    // Builds from the first complete message in data; empty if truncated
+    static MidiMessage fromBytes(const uint8_t* data, size_t size, qint64 timestampUs = -1)
+    {
+        if (size == 0 || !(data[0] & 0x80) || data[0] == 0xF0) {
+            return MidiMessage();
+        }
+        size_t length = 1 + dataLength(data[0]);
+        if (size < length) {
+            return MidiMessage();
+        }
+        return make(data[0], length > 1 ? data[1] : 0, length > 2 ? data[2] : 0, timestampUs);
+    }
+
+    // Number of data bytes following a status byte
+    static int dataLength(uint8_t status)
+    {
+        // Indexed by high nibble for channel messages (0x8-0xE)
+        static constexpr uint8_t CHANNEL_LENGTH[16] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 1, 1, 2, 0
+        };
+        // Indexed by low nibble for system messages (0xF0-0xFF)
+        static constexpr uint8_t SYSTEM_LENGTH[16] = {
+            0, 1, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+        };
+        return status >= 0xF0 ? SYSTEM_LENGTH[status & 0x0F] : CHANNEL_LENGTH[status >> 4];
+    }
+
+    bool isEmpty() const { return length == 0; }
+    uint8_t status() const { return bytes[0]; }
+    uint8_t type() const { return bytes[0] & 0xF0; }
+    uint8_t channel() const { return bytes[0] & 0x0F; }
+    uint8_t data1() const { return bytes[1]; }
+    uint8_t data2() const { return bytes[2]; }
+    const char* constData() const { return reinterpret_cast<const char*>(bytes); }
+};
+
+static_assert(std::is_trivially_copyable<MidiMessage>::value,
+              "MidiMessage must stay trivially copyable");
+
+/**
+ * Complete SysEx message (F0 ... F7) backed by a pooled, reference-counted
+ * buffer. Copies share the buffer; the last one returns it to the pool, so
+ * steady-state SysEx traffic reuses storage instead of allocating.
+ */
+class SysExMessage
+{
+public:
+    SysExMessage() = default;
+    SysExMessage(const SysExMessage& other);
+    SysExMessage(SysExMessage&& other) noexcept;
+    SysExMessage& operator=(const SysExMessage& other);
+    SysExMessage& operator=(SysExMessage&& other) noexcept;
+    ~SysExMessage();
+
+    static SysExMessage fromBytes(const uint8_t* data, size_t size, qint64 timestampUs = -1);
+
+    const uint8_t* data() const;
+    size_t size() const;
+    bool isEmpty() const { return size() == 0; }
+    qint64 timestampUs() const { return m_timestampUs; }
+    uint8_t source() const { return m_source; }
+    void setSource(uint8_t source) { m_source = source; }
+
+    struct Buffer {
+        std::atomic<int> refs{0};
+        std::vector<uint8_t> bytes;
+    };
+
+private:
+    void release();
+
+    Buffer* m_buffer = nullptr;
+    qint64 m_timestampUs = -1;
+    uint8_t m_source = MidiMessage::LOCAL_SOURCE;
+};
+
+Q_DECLARE_METATYPE(MidiMessage)
+Q_DECLARE_METATYPE(SysExMessage)
+
+#endif // MIDIMESSAGE_H
@@ -0,0 +1,116 @@
+#ifndef MIDIPARSER_H
+#define MIDIPARSER_H
+
+#include <QByteArray>
+#include <cstdint>
+#include <vector>
+#include "MidiMessage.h"
+
+/**
+ * Table-driven MIDI byte stream parser.
+ *
+ * Handles running status, 1- and 2-data-byte messages, system common and
+ * realtime bytes interleaved between or inside short messages. Complete
+ * short messages are appended to a caller-owned vector so a whole read
+ * becomes one batch; SysEx is collected in a reused, capped buffer and
+ * handed to a callback on 0xF7. Nothing allocates in steady state.
+ *
+ * Inside SysEx only 0xF7 (end) and 0xF0 (restart) are special: the device's
+ * responses use command bytes 0x80 and up, so everything else is payload.
+ */
+class MidiParser
+{
+public:
+    static constexpr int DEFAULT_MAX_SYSEX_BYTES = 512;
+
+    explicit MidiParser(int maxSysExBytes = DEFAULT_MAX_SYSEX_BYTES)
+        : m_maxSysExBytes(maxSysExBytes)
+    {
+        m_sysEx.reserve(m_maxSysExBytes);
+    }
+
+    void reset()
+    {
+        m_status = 0;
+        m_needed = 0;
+        m_count = 0;
+        m_inSysEx = false;
+        m_sysExOverflow = false;
+        m_sysEx.resize(0);
+    }
+
+    // SysEx messages discarded for exceeding maxSysExBytes
+    quint64 overflowCount() const { return m_overflows; }
+
+    // onSysEx(const QByteArray&) receives each complete F0 ... F7 message;
+    // the buffer is only valid for the duration of the call
+    template <typename SysExHandler>
+    void parse(const char* data, int size, std::vector<MidiMessage>& events, SysExHandler&& onSysEx,
+               qint64 timestampUs = -1)
+    {
+        for (int i = 0; i < size; i++) {
+            uint8_t byte = static_cast<uint8_t>(data[i]);
+
+            if (m_inSysEx && byte != 0xF0 && byte != 0xF7) {
+                if (m_sysEx.size() < m_maxSysExBytes - 1) {
+                    m_sysEx.append(static_cast<char>(byte));
+                } else {
+                    m_sysExOverflow = true;
+                }
+            } else if (byte >= 0xF8) {
+                // Realtime: never disturbs running status
+                events.push_back(MidiMessage::make(byte, 0, 0, timestampUs));
+            } else if (byte == 0xF0) {
+                m_inSysEx = true;
+                m_sysExOverflow = false;
+                m_sysEx.resize(0);
+                m_sysEx.append(static_cast<char>(byte));
+                m_status = 0;
+            } else if (byte == 0xF7) {
+                if (m_inSysEx) {
+                    m_inSysEx = false;
+                    if (!m_sysExOverflow) {
+                        m_sysEx.append(static_cast<char>(byte));
+                        onSysEx(m_sysEx);
+                    } else {
+                        m_overflows++;
+                    }
+                    m_sysEx.resize(0);
+                }
+            } else if (byte & 0x80) {
+                m_status = byte;
+                m_count = 0;
+                m_needed = MidiMessage::dataLength(byte);
+                if (m_needed == 0) {
+                    events.push_back(MidiMessage::make(byte, 0, 0, timestampUs));
+                    m_status = 0;
+                }
+            } else if (m_status != 0) {
+                m_data[m_count++] = byte;
+                if (m_count == m_needed) {
+                    events.push_back(MidiMessage::make(m_status, m_data[0],
+                                                       m_count == 2 ? m_data[1] : uint8_t(0),
+                                                       timestampUs));
+                    m_count = 0;
+                    // System common messages don't establish running status
+                    if (m_status >= 0xF0) {
+                        m_status = 0;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    QByteArray m_sysEx;
+    int m_maxSysExBytes;
+    uint8_t m_status = 0;       // Running status (0 = none)
+    uint8_t m_data[2] = {0, 0};
+    int m_needed = 0;
+    int m_count = 0;
+    bool m_inSysEx = false;
+    bool m_sysExOverflow = false;
+    quint64 m_overflows = 0;
+};
+
+#endif // MIDIPARSER_H
@@ -0,0 +1,273 @@
+#include "MidiRouter.h"
+#include <QDebug>
+#include <algorithm>
+
+// =============================================================================
+// RouteRule Text Form
+// =============================================================================
+
+namespace {
+
+bool parseRange(const QString& text, int minimum, int maximum, int& low, int& high)
+{
+    QStringList parts = text.split('-');
+    bool okLow = false;
+    bool okHigh = false;
+    if (parts.size() == 1) {
+        low = high = parts[0].toInt(&okLow);
+        okHigh = okLow;
+    } else if (parts.size() == 2) {
+        low = parts[0].toInt(&okLow);
+        high = parts[1].toInt(&okHigh);
+    }
+    return okLow && okHigh && low >= minimum && high <= maximum && low <= high;
+}
+
+QString formatRange(int low, int high)
+{
+    return low == high ? QString::number(low) : QString("%1-%2").arg(low).arg(high);
+}
+
+} // namespace
+
+QString RouteRule::toString() const
+{
+    QStringList fields;
+    fields << (inputChannel < 0 ? QString("in=*") : QString("in=%1").arg(inputChannel + 1));
+    if (keyLow != 0 || keyHigh != 127) {
+        fields << "keys=" + formatRange(keyLow, keyHigh);
+    }
+    if (velocityLow != 0 || velocityHigh != 127) {
+        fields << "vel=" + formatRange(velocityLow, velocityHigh);
+    }
+
+    QStringList targets;
+    for (int fm = 0; fm < MidiRouter::FM_CHANNELS; fm++) {
+        if (targetMask & (1 << fm)) {
+            targets << QString::number(fm + 1);
+        }
+    }
+    fields << "out=" + targets.join(',');
+
+    if (transpose != 0) {
+        fields << QString("transpose=%1").arg(transpose);
+    }
+    return fields.join(' ');
+}
+
+bool RouteRule::fromString(const QString& text, RouteRule& rule, QString* error)
+{
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    rule = RouteRule();
+    bool haveTargets = false;
+
+    const QStringList fields = text.simplified().split(' ', Qt::SkipEmptyParts);
+    for (const QString& field : fields) {
+        int eq = field.indexOf('=');
+        if (eq <= 0) {
+            return fail("Expected key=value: " + field);
+        }
+        QString key = field.left(eq).toLower();
+        QString value = field.mid(eq + 1);
+        int low = 0;
+        int high = 0;
+
+        if (key == "in") {
+            if (value == "*") {
+                rule.inputChannel = -1;
+            } else if (parseRange(value, 1, 16, low, high) && low == high) {
+                rule.inputChannel = low - 1;
+            } else {
+                return fail("Input channel must be 1-16 or *: " + value);
+            }
+        } else if (key == "keys") {
+            if (!parseRange(value, 0, 127, low, high)) {
+                return fail("Key range must be within 0-127: " + value);
+            }
+            rule.keyLow = static_cast<uint8_t>(low);
+            rule.keyHigh = static_cast<uint8_t>(high);
+        } else if (key == "vel") {
+            if (!parseRange(value, 0, 127, low, high)) {
+                return fail("Velocity range must be within 0-127: " + value);
+            }
+            rule.velocityLow = static_cast<uint8_t>(low);
+            rule.velocityHigh = static_cast<uint8_t>(high);
+        } else if (key == "out") {
+            rule.targetMask = 0;
+            for (const QString& target : value.split(',', Qt::SkipEmptyParts)) {
+                bool ok = false;
+                int channel = target.toInt(&ok);
+                if (!ok || channel < 1 || channel > MidiRouter::FM_CHANNELS) {
+                    return fail("FM channel must be 1-6: " + target);
+                }
+                rule.targetMask |= static_cast<uint8_t>(1 << (channel - 1));
+            }
+            haveTargets = rule.targetMask != 0;
+        } else if (key == "transpose") {
+            bool ok = false;
+            rule.transpose = value.toInt(&ok);
+            if (!ok || rule.transpose < -127 || rule.transpose > 127) {
+                return fail("Transpose must be -127 to 127: " + value);
+            }
+        } else {
+            return fail("Unknown field: " + key);
+        }
+    }
+
+    if (!haveTargets) {
+        return fail("Rule has no out= channels");
+    }
+    return true;
+}
+
+// =============================================================================
+// MidiRouter
+// =============================================================================
+
+std::vector<RouteRule> MidiRouter::parseRules(const QStringList& lines, QStringList* errors)
+{
+    std::vector<RouteRule> rules;
+    for (int i = 0; i < lines.size(); i++) {
+        QString line = lines[i].section('#', 0, 0).trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        RouteRule rule;
+        QString error;
+        if (RouteRule::fromString(line, rule, &error)) {
+            rules.push_back(rule);
+        } else if (errors) {
+            errors->append(QString("Line %1: %2").arg(i + 1).arg(error));
+        }
+    }
+    return rules;
+}
+
+QStringList MidiRouter::formatRules(const std::vector<RouteRule>& rules)
+{
+    QStringList lines;
+    for (const RouteRule& rule : rules) {
+        lines << rule.toString();
+    }
+    return lines;
+}
+
+bool MidiRouter::sameRoute(const Table* a, const Table* b, int channel, int key)
+{
+    const bool routedA = a && a->routed[channel];
+    const bool routedB = b && b->routed[channel];
+    if (!routedA || !routedB) {
+        return routedA == routedB;   // Both pass through unchanged
+    }
+
+    const KeyRoute& routeA = a->keys[channel * 128 + key];
+    const KeyRoute& routeB = b->keys[channel * 128 + key];
+    if (routeA.count != routeB.count) {
+        return false;
+    }
+    for (int i = 0; i < routeA.count; i++) {
+        if (routeA.targets[i].channel != routeB.targets[i].channel ||
+            routeA.targets[i].key != routeB.targets[i].key) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MidiRouter::setRules(const std::vector<RouteRule>& rules, std::vector<MidiMessage>* released)
+{
+    m_rules = rules;
+
+    std::unique_ptr<Table> table;
+    if (!rules.empty()) {
+        table = std::make_unique<Table>();
+        compile(rules, *table);
+    }
+
+    const Table* previous = m_active.load(std::memory_order_acquire);
+    m_active.store(table.get(), std::memory_order_release);
+
+    // Held notes whose destinations change are released where they were
+    // started; their note-offs would now take the new route
+    int releasedCount = 0;
+    for (int channel = 0; channel < 16; channel++) {
+        for (int half = 0; half < 2; half++) {
+            uint64_t held = m_held[channel * 2 + half].load(std::memory_order_relaxed);
+            for (int bit = 0; bit < 64; bit++) {
+                if (!(held & (uint64_t(1) << bit))) {
+                    continue;
+                }
+                int key = half * 64 + bit;
+                if (sameRoute(previous, table.get(), channel, key)) {
+                    continue;
+                }
+                m_held[channel * 2 + half].fetch_and(~(uint64_t(1) << bit), std::memory_order_relaxed);
+                MidiMessage noteOff = MidiMessage::make(static_cast<uint8_t>(0x80 | channel),
+                                                        static_cast<uint8_t>(key), 0);
+                releasedCount += routeThrough(previous, noteOff, [released](const MidiMessage& out) {
+                    if (released) {
+                        released->push_back(out);
+                    }
+                });
+            }
+        }
+    }
+
+    // The previous table stays until the next swap in case an input thread
+    // is still routing through it; anything older is freed
+    const Table* active = table.get();
+    if (table) {
+        m_tables.push_back(std::move(table));
+    }
+    m_tables.erase(std::remove_if(m_tables.begin(), m_tables.end(),
+                                  [active, previous](const std::unique_ptr<Table>& retired) {
+                                      return retired.get() != active && retired.get() != previous;
+                                  }),
+                   m_tables.end());
+
+    qDebug() << "MidiRouter: compiled" << rules.size() << "rules," << releasedCount << "notes released";
+}
+
+void MidiRouter::compile(const std::vector<RouteRule>& rules, Table& table)
+{
+    int dropped = 0;
+
+    for (const RouteRule& rule : rules) {
+        int firstChannel = rule.inputChannel < 0 ? 0 : rule.inputChannel;
+        int lastChannel = rule.inputChannel < 0 ? 15 : rule.inputChannel;
+
+        for (int channel = firstChannel; channel <= lastChannel; channel++) {
+            table.routed[channel] = true;
+            table.channelMask[channel] |= rule.targetMask;
+
+            for (int key = rule.keyLow; key <= rule.keyHigh; key++) {
+                int outKey = key + rule.transpose;
+                if (outKey < 0 || outKey > 127) {
+                    continue;
+                }
+                KeyRoute& route = table.keys[channel * 128 + key];
+                for (int fm = 0; fm < FM_CHANNELS; fm++) {
+                    if (!(rule.targetMask & (1 << fm))) {
+                        continue;
+                    }
+                    if (route.count == MAX_TARGETS) {
+                        dropped++;
+                        continue;
+                    }
+                    route.targets[route.count++] = {static_cast<uint8_t>(fm),
+                                                     static_cast<uint8_t>(outKey),
+                                                     rule.velocityLow, rule.velocityHigh};
+                }
+            }
+        }
+    }
+
+    if (dropped > 0) {
+        qWarning() << "MidiRouter: more than" << MAX_TARGETS
+                   << "destinations on some keys," << dropped << "dropped";
+    }
+}
@@ -0,0 +1,163 @@
+#ifndef MIDIROUTER_H
+#define MIDIROUTER_H
+
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MidiMessage.h"
+
+/**
+ * One routing rule: notes on an input channel inside a key and velocity
+ * window are sent to one or more FM channels, optionally transposed.
+ *
+ * Text form (one rule per line, 1-based channels as shown in the UI):
+ *   in=1 keys=0-59 vel=1-127 out=1,2 transpose=-12
+ * "in=*" matches any input channel; keys, vel and transpose are optional.
+ */
+struct RouteRule {
+    int inputChannel = -1;      // 0-15, -1 = any
+    uint8_t keyLow = 0;
+    uint8_t keyHigh = 127;
+    uint8_t velocityLow = 0;
+    uint8_t velocityHigh = 127;
+    uint8_t targetMask = 0;     // Bit n = FM channel n (0-5)
+    int transpose = 0;
+
+    QString toString() const;
+    static bool fromString(const QString& text, RouteRule& rule, QString* error = nullptr);
+};
+
+/**
+ * Channel remap, key split and layer stage between MIDI input and serial.
+ *
+ * Rules are compiled into flat 16x128 tables indexed by (channel, key), so
+ * routing a message is one table lookup on the MIDI input thread. Input
+ * channels with no rule pass through untouched; on a routed channel, notes
+ * outside every rule are dropped and channel-wide messages (CC, program,
+ * pitch bend, aftertouch) go to every FM channel that channel feeds.
+ *
+ * setRules() runs on the GUI thread and publishes a new table with an
+ * atomic pointer swap. A retired table is freed once it is two swaps old;
+ * an input thread finishes a route() long before the user can edit the
+ * rules twice. route() keeps a bitmap of held input notes, so setRules()
+ * can return note-offs, routed through the old table, for held notes whose
+ * destinations change; their note-offs would otherwise follow the new
+ * table and leave the old destinations hanging.
+ */
+class MidiRouter
+{
+public:
+    static constexpr int MAX_TARGETS = 8;   // Destinations per (channel, key)
+    static constexpr int FM_CHANNELS = 6;
+
+    MidiRouter() = default;
+    MidiRouter(const MidiRouter&) = delete;
+    MidiRouter& operator=(const MidiRouter&) = delete;
+
+    // Appends to released (if given) the note-offs for held notes whose
+    // routing changes
+    void setRules(const std::vector<RouteRule>& rules,
+                  std::vector<MidiMessage>* released = nullptr);
+    std::vector<RouteRule> rules() const { return m_rules; }
+    bool isActive() const { return m_active.load(std::memory_order_acquire) != nullptr; }
+
+    static std::vector<RouteRule> parseRules(const QStringList& lines, QStringList* errors = nullptr);
+    static QStringList formatRules(const std::vector<RouteRule>& rules);
+
+    // Calls sink(const MidiMessage&) for each routed copy of message.
+    // Safe to call from the MIDI input thread concurrently with setRules().
+    template <typename Sink>
+    int route(const MidiMessage& message, Sink&& sink) const
+    {
+        uint8_t type = message.type();
+        if (type == 0x80 || type == 0x90) {
+            const int index = message.channel() * 2 + (message.data1() >> 6);
+            const uint64_t bit = uint64_t(1) << (message.data1() & 63);
+            if (type == 0x90 && message.data2() > 0) {
+                m_held[index].fetch_or(bit, std::memory_order_relaxed);
+            } else {
+                m_held[index].fetch_and(~bit, std::memory_order_relaxed);
+            }
+        }
+        return routeThrough(m_active.load(std::memory_order_acquire), message, sink);
+    }
+
+private:
+    struct Table;
+
+    template <typename Sink>
+    static int routeThrough(const Table* table, const MidiMessage& message, Sink&& sink)
+    {
+        uint8_t status = message.status();
+        if (!table || status >= 0xF0 || !table->routed[status & 0x0F]) {
+            sink(message);
+            return 1;
+        }
+
+        uint8_t type = status & 0xF0;
+        uint8_t channel = status & 0x0F;
+        int sent = 0;
+
+        if (type == 0x80 || type == 0x90 || type == 0xA0) {
+            const KeyRoute& route = table->keys[channel * 128 + message.data1()];
+            // Velocity windows only select note-ons; note-offs and poly
+            // pressure follow every layer so nothing is left hanging
+            bool noteOn = type == 0x90 && message.data2() > 0;
+            for (int i = 0; i < route.count; i++) {
+                const Target& target = route.targets[i];
+                if (noteOn && (message.data2() < target.velocityLow ||
+                               message.data2() > target.velocityHigh)) {
+                    continue;
+                }
+                MidiMessage out = message;
+                out.bytes[0] = type | target.channel;
+                out.bytes[1] = target.key;
+                sink(out);
+                sent++;
+            }
+        } else {
+            uint8_t mask = table->channelMask[channel];
+            for (int fm = 0; fm < FM_CHANNELS; fm++) {
+                if (mask & (1 << fm)) {
+                    MidiMessage out = message;
+                    out.bytes[0] = type | fm;
+                    sink(out);
+                    sent++;
+                }
+            }
+        }
+        return sent;
+    }
+
+    struct Target {
+        uint8_t channel;
+        uint8_t key;
+        uint8_t velocityLow;
+        uint8_t velocityHigh;
+    };
+
+    struct KeyRoute {
+        uint8_t count = 0;
+        Target targets[MAX_TARGETS];
+    };
+
+    struct Table {
+        std::array<KeyRoute, 16 * 128> keys;
+        std::array<uint8_t, 16> channelMask{};  // FM channels fed by each input channel
+        std::array<bool, 16> routed{};          // Input channel has at least one rule
+    };
+
+    static void compile(const std::vector<RouteRule>& rules, Table& table);
+    static bool sameRoute(const Table* a, const Table* b, int channel, int key);
+
+    std::atomic<const Table*> m_active{nullptr};
+    std::vector<std::unique_ptr<Table>> m_tables;   // Active and previous; GUI thread only
+    std::vector<RouteRule> m_rules;
+    mutable std::array<std::atomic<uint64_t>, 16 * 2> m_held{};   // Held input notes by (channel, key)
+};
+
+#endif // MIDIROUTER_H
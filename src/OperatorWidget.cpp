@@ -121,17 +121,20 @@ void OperatorWidget::setupUI()
 
     outerLayout->addLayout(mainLayout, 1);
 
-    // Connect signals
-    connect(m_mul, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_dt, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_tl, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_rs, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_ar, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_dr, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_sr, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_rr, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_sl, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
-    connect(m_ssg, QOverload<int>::of(&QSpinBox::valueChanged), this, &OperatorWidget::onValueChanged);
+    // Connect signals - each spinbox reports which field it edits
+    const std::pair<QSpinBox*, FMParam> params[] = {
+        {m_mul, FMParam::Mul}, {m_dt, FMParam::Dt}, {m_tl, FMParam::Tl},
+        {m_rs, FMParam::Rs}, {m_ar, FMParam::Ar}, {m_dr, FMParam::Dr},
+        {m_sr, FMParam::Sr}, {m_rr, FMParam::Rr}, {m_sl, FMParam::Sl},
+        {m_ssg, FMParam::Ssg}
+    };
+    for (const auto& [spinBox, param] : params) {
+        connect(spinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [this, param = param](int value) {
+            if (!m_updating) {
+                emit parameterChanged(param, value);
+            }
+        });
+    }
 
     // TL bar and spinbox sync
     connect(m_tlBar, &TLBarWidget::valueChanged, this, [this](int value) {
@@ -193,13 +196,6 @@ void OperatorWidget::setCarrier(bool isCarrier)
     }
 }
 
-void OperatorWidget::onValueChanged()
-{
-    if (!m_updating) {
-        emit operatorChanged();
-    }
-}
-
 void OperatorWidget::setAR(int value)
 {
     if (m_ar->value() != value) {
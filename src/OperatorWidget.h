@@ -32,13 +32,15 @@ public:
     void setRR(int value);
 
 signals:
+    // Several fields changed at once (paste, reset)
     void operatorChanged();
+    // A single field was edited by the user
+    void parameterChanged(FMParam param, int value);
 
 protected:
     void contextMenuEvent(QContextMenuEvent* event) override;
 
 private slots:
-    void onValueChanged();
     void onCopyOperator();
     void onPasteOperator();
     void onResetOperator();
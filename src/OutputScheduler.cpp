@@ -0,0 +1,239 @@
+#include "OutputScheduler.h"
+#include "SerialManager.h"
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+
+OutputScheduler::OutputScheduler(SerialManager* serial)
+    : m_serial(serial)
+{
+    // Reserved up front so scheduling never reallocates under the lock
+    m_heap.reserve(MAX_PENDING);
+    m_due.reserve(MAX_PENDING);
+}
+
+OutputScheduler::~OutputScheduler()
+{
+    stop();
+}
+
+qint64 OutputScheduler::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// =============================================================================
+// Thread Control
+// =============================================================================
+
+void OutputScheduler::start()
+{
+    if (m_thread) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = true;
+    }
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("OutputScheduler");
+    m_thread->start(QThread::TimeCriticalPriority);
+}
+
+void OutputScheduler::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_one();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    Stats totals = stats();
+    if (totals.dispatched > 0) {
+        qDebug() << "OutputScheduler:" << totals.dispatched << "events," << totals.written
+                 << "written," << totals.late << "late, mean" << totals.meanLatenessUs
+                 << "us, max" << totals.maxLatenessUs << "us";
+    }
+}
+
+// =============================================================================
+// Scheduling
+// =============================================================================
+
+bool OutputScheduler::schedule(const MidiMessage& message, qint64 dueUs)
+{
+    if (message.isEmpty()) {
+        return false;
+    }
+    Event event;
+    event.dueUs = dueUs;
+    event.message = message;
+    return push(std::move(event));
+}
+
+bool OutputScheduler::schedule(const SysExMessage& message, qint64 dueUs)
+{
+    if (message.isEmpty()) {
+        return false;
+    }
+    Event event;
+    event.dueUs = dueUs;
+    event.sysex = message;
+    return push(std::move(event));
+}
+
+bool OutputScheduler::push(Event event)
+{
+    event.scheduledUs = nowUs();
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (static_cast<int>(m_heap.size()) >= MAX_PENDING) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        event.sequence = m_nextSequence++;
+        m_heap.push_back(std::move(event));
+        std::push_heap(m_heap.begin(), m_heap.end(), later);
+
+        // Only a new earliest deadline changes how long the thread waits
+        wake = m_heap.front().sequence == m_nextSequence - 1;
+    }
+    if (wake) {
+        m_wake.notify_one();
+    }
+    return true;
+}
+
+int OutputScheduler::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int dropped = static_cast<int>(m_heap.size());
+    m_heap.clear();
+    return dropped;
+}
+
+int OutputScheduler::pending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_heap.size());
+}
+
+// =============================================================================
+// Dispatch Thread
+// =============================================================================
+
+void OutputScheduler::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        if (m_heap.empty()) {
+            m_wake.wait(lock);
+            continue;
+        }
+
+        const qint64 compensationUs = m_compensationUs.load(std::memory_order_relaxed);
+        const qint64 dueUs = m_heap.front().dueUs - compensationUs;
+        qint64 now = nowUs();
+
+        // Coarse phase: sleep until the spin window, waking early if an
+        // earlier event arrives or we're stopped
+        if (dueUs - now > SPIN_WINDOW_US) {
+            auto wakeAt = std::chrono::steady_clock::time_point(
+                std::chrono::microseconds(dueUs - SPIN_WINDOW_US));
+            m_wake.wait_until(lock, wakeAt);
+            continue;
+        }
+
+        // Fine phase: spin without the lock so producers aren't blocked
+        if (dueUs > now) {
+            lock.unlock();
+            while (nowUs() < dueUs) {
+                QThread::yieldCurrentThread();
+            }
+            lock.lock();
+            continue;   // An earlier event may have arrived meanwhile
+        }
+
+        // Everything due by now goes out in one pass, outside the lock
+        while (!m_heap.empty() && m_heap.front().dueUs - compensationUs <= now) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), later);
+            m_due.push_back(std::move(m_heap.back()));
+            m_heap.pop_back();
+        }
+        lock.unlock();
+        for (const Event& event : m_due) {
+            dispatch(event, compensationUs);
+        }
+        m_due.clear();
+        lock.lock();
+    }
+}
+
+void OutputScheduler::dispatch(const Event& event, qint64 compensationUs)
+{
+    // Lateness is stamped by the transport once the bytes are written
+    const qint64 sendAtUs = qMax(event.dueUs - compensationUs, event.scheduledUs);
+    bool queued = !event.message.isEmpty() ? m_serial->sendTimed(event.message, sendAtUs)
+                                           : m_serial->sendTimed(event.sysex, sendAtUs);
+
+    m_dispatched.fetch_add(1, std::memory_order_relaxed);
+    if (!queued) {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// =============================================================================
+// Statistics
+// =============================================================================
+
+void OutputScheduler::recordWrite(qint64 sendAtUs)
+{
+    const qint64 latenessUs = qMax<qint64>(0, nowUs() - sendAtUs);
+    m_written.fetch_add(1, std::memory_order_relaxed);
+    if (latenessUs > LATE_THRESHOLD_US) {
+        m_late.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_totalLatenessUs.fetch_add(latenessUs, std::memory_order_relaxed);
+    qint64 maxLateness = m_maxLatenessUs.load(std::memory_order_relaxed);
+    while (latenessUs > maxLateness &&
+           !m_maxLatenessUs.compare_exchange_weak(maxLateness, latenessUs,
+                                                  std::memory_order_relaxed)) {}
+}
+
+OutputScheduler::Stats OutputScheduler::stats() const
+{
+    Stats stats;
+    stats.dispatched = m_dispatched.load(std::memory_order_relaxed);
+    stats.failed = m_failed.load(std::memory_order_relaxed);
+    stats.written = m_written.load(std::memory_order_relaxed);
+    stats.late = m_late.load(std::memory_order_relaxed);
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.maxLatenessUs = m_maxLatenessUs.load(std::memory_order_relaxed);
+    if (stats.written > 0) {
+        stats.meanLatenessUs = static_cast<double>(m_totalLatenessUs.load(std::memory_order_relaxed)) /
+                               static_cast<double>(stats.written);
+    }
+    return stats;
+}
+
+void OutputScheduler::resetStats()
+{
+    m_dispatched.store(0, std::memory_order_relaxed);
+    m_failed.store(0, std::memory_order_relaxed);
+    m_written.store(0, std::memory_order_relaxed);
+    m_late.store(0, std::memory_order_relaxed);
+    m_rejected.store(0, std::memory_order_relaxed);
+    m_maxLatenessUs.store(0, std::memory_order_relaxed);
+    m_totalLatenessUs.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,124 @@
+#ifndef OUTPUTSCHEDULER_H
+#define OUTPUTSCHEDULER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "MidiMessage.h"
+
+class QThread;
+class SerialManager;
+
+/**
+ * Sends MIDI at future points in time from a dedicated dispatch thread.
+ *
+ * Producers on any thread schedule events for an absolute due time in
+ * steady-clock microseconds, the clock MIDIManager stamps input with (see
+ * nowUs()). Events wait in a min-heap ordered by due time and then arrival
+ * order, so events due at the same time go out in the order they were
+ * scheduled. Events already due are sent immediately.
+ *
+ * The dispatch thread runs at time-critical priority. It sleeps on a
+ * condition variable until SPIN_WINDOW_US before the next deadline, then
+ * spins the rest of the way, because OS sleeps overshoot by up to a
+ * millisecond. Deadlines are met to within about 100 us.
+ *
+ * A latency compensation (normally the device's measured one-way latency)
+ * can be set, and every event is then sent that much before its due time so
+ * it sounds on time.
+ *
+ * Lateness is measured when the transport writes the event's last byte to
+ * the port, so time spent behind coalescing, pacing or other traffic
+ * counts. The transport reports each write through recordWrite(), and
+ * running totals are kept in stats().
+ */
+class OutputScheduler
+{
+public:
+    struct Stats {
+        quint64 dispatched = 0;
+        quint64 failed = 0;         // Not connected or TX ring full
+        quint64 written = 0;        // Reached the port; lateness covers these
+        quint64 late = 0;           // Later than LATE_THRESHOLD_US
+        quint64 rejected = 0;       // Scheduler full
+        qint64 maxLatenessUs = 0;
+        double meanLatenessUs = 0.0;
+    };
+
+    static constexpr int MAX_PENDING = 4096;
+    static constexpr qint64 SPIN_WINDOW_US = 1500;
+    static constexpr qint64 LATE_THRESHOLD_US = 100;
+
+    explicit OutputScheduler(SerialManager* serial);
+    ~OutputScheduler();
+    OutputScheduler(const OutputScheduler&) = delete;
+    OutputScheduler& operator=(const OutputScheduler&) = delete;
+
+    void start();
+    void stop();
+
+    // Thread-safe. Return false if the scheduler already holds MAX_PENDING events.
+    bool schedule(const MidiMessage& message, qint64 dueUs);
+    bool schedule(const SysExMessage& message, qint64 dueUs);
+
+    // Thread-safe: drop everything not yet sent; returns the count
+    int clear();
+    int pending() const;
+
+    // Thread-safe: send every event this much before its due time
+    void setLatencyCompensation(qint64 us)
+    {
+        m_compensationUs.store(qMax<qint64>(0, us), std::memory_order_relaxed);
+    }
+    qint64 latencyCompensation() const { return m_compensationUs.load(std::memory_order_relaxed); }
+
+    // Thread-safe: the transport wrote the last byte of an event that was
+    // due to be sent at sendAtUs
+    void recordWrite(qint64 sendAtUs);
+    Stats stats() const;
+    void resetStats();
+
+    static qint64 nowUs();
+
+private:
+    struct Event {
+        qint64 dueUs = 0;
+        qint64 scheduledUs = 0;     // Events scheduled in the past aren't late on our account
+        quint64 sequence = 0;
+        MidiMessage message;
+        SysExMessage sysex;         // Used when message is empty
+    };
+
+    // std::push_heap builds a max-heap; "later" on top inverts it
+    static bool later(const Event& a, const Event& b)
+    {
+        return a.dueUs != b.dueUs ? a.dueUs > b.dueUs : a.sequence > b.sequence;
+    }
+
+    bool push(Event event);
+    void run();
+    void dispatch(const Event& event, qint64 compensationUs);
+
+    SerialManager* m_serial;
+    QThread* m_thread = nullptr;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<Event> m_heap;      // Guarded by m_mutex
+    std::vector<Event> m_due;       // Dispatch thread only
+    quint64 m_nextSequence = 0;     // Guarded by m_mutex
+    bool m_running = false;         // Guarded by m_mutex
+
+    std::atomic<qint64> m_compensationUs{0};
+    std::atomic<quint64> m_dispatched{0};
+    std::atomic<quint64> m_failed{0};
+    std::atomic<quint64> m_written{0};
+    std::atomic<quint64> m_late{0};
+    std::atomic<quint64> m_rejected{0};
+    std::atomic<qint64> m_maxLatenessUs{0};
+    std::atomic<qint64> m_totalLatenessUs{0};
+};
+
+#endif // OUTPUTSCHEDULER_H
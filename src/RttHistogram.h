@@ -0,0 +1,95 @@
+#ifndef RTTHISTOGRAM_H
+#define RTTHISTOGRAM_H
+
+#include <QtGlobal>
+#include <array>
+#include <cmath>
+
+/**
+ * Rolling histogram of the last WINDOW round-trip times.
+ *
+ * Buckets are a quarter octave wide starting at BASE_US, so any percentile
+ * is within about 19% of the true value. The highest bucket runs past four
+ * seconds. Samples are kept in a ring so the oldest can be taken back out
+ * of its bucket. That keeps memory and work fixed however long the monitor
+ * runs. Percentiles report their bucket's upper bound, capped at the window
+ * maximum.
+ *
+ * Not thread-safe; SerialManager uses it from the GUI thread only.
+ */
+class RttHistogram
+{
+public:
+    static constexpr int WINDOW = 256;
+    static constexpr int BUCKETS = 64;
+    static constexpr qint64 BASE_US = 64;     // Upper bound of bucket 0
+
+    void add(qint64 rttUs)
+    {
+        if (m_count == WINDOW) {
+            m_counts[bucketFor(m_samples[m_next])]--;
+        } else {
+            m_count++;
+        }
+        m_samples[m_next] = rttUs;
+        m_counts[bucketFor(rttUs)]++;
+        m_next = (m_next + 1) % WINDOW;
+    }
+
+    void reset()
+    {
+        m_counts.fill(0);
+        m_count = 0;
+        m_next = 0;
+    }
+
+    int count() const { return m_count; }
+
+    // fraction in (0, 1]; 0 when empty
+    qint64 percentile(double fraction) const
+    {
+        if (m_count == 0) {
+            return 0;
+        }
+        int rank = qMax(1, static_cast<int>(std::ceil(fraction * m_count)));
+        int seen = 0;
+        for (int bucket = 0; bucket < BUCKETS; bucket++) {
+            seen += m_counts[bucket];
+            if (seen >= rank) {
+                return qMin(upperBound(bucket), max());
+            }
+        }
+        return max();
+    }
+
+    qint64 max() const
+    {
+        qint64 largest = 0;
+        for (int i = 0; i < m_count; i++) {
+            largest = qMax(largest, m_samples[i]);
+        }
+        return largest;
+    }
+
+private:
+    static int bucketFor(qint64 rttUs)
+    {
+        if (rttUs <= BASE_US) {
+            return 0;
+        }
+        int bucket = static_cast<int>(std::ceil(4.0 * std::log2(static_cast<double>(rttUs) / BASE_US)));
+        return qBound(0, bucket, BUCKETS - 1);
+    }
+
+    static qint64 upperBound(int bucket)
+    {
+        return static_cast<qint64>(BASE_US * std::exp2(bucket / 4.0));
+    }
+
+    std::array<qint64, WINDOW> m_samples{};
+    std::array<int, BUCKETS> m_counts{};
+    int m_count = 0;
+    int m_next = 0;
+};
+
+#endif // RTTHISTOGRAM_H
@@ -1,24 +1,61 @@
 #include "SerialManager.h"
 #include <QDebug>
+#include <algorithm>
+#include <cmath>
 
 SerialManager::SerialManager(QObject* parent)
     : QObject(parent)
-    , m_port(new QSerialPort(this))
+    , m_transportThread(new QThread(this))
+    , m_transport(new SerialTransport())
+    , m_scheduler(new OutputScheduler(this))
     , m_autoDetectTimer(new QTimer(this))
-    , m_inSysEx(false)
     , m_state(ConnectionState::Disconnected)
+    , m_bulkTimer(new QTimer(this))
+    , m_baudTimer(new QTimer(this))
+    , m_calibrationTimer(new QTimer(this))
+    , m_healthTimer(new QTimer(this))
+    , m_telemetryTimer(new QTimer(this))
 {
-    QObject::connect(m_port, &QSerialPort::readyRead,
-                     this, &SerialManager::onReadyRead);
-    QObject::connect(m_port, &QSerialPort::errorOccurred,
+    m_rxEvents.reserve(RX_EVENT_RESERVE);
+
+    m_transportThread->setObjectName("SerialTransport");
+    m_transport->moveToThread(m_transportThread);
+    m_transport->setScheduler(m_scheduler);
+
+    QObject::connect(m_transport, &SerialTransport::dataReceived,
+                     this, &SerialManager::onDataReceived);
+    QObject::connect(m_transport, &SerialTransport::errorOccurred,
                      this, &SerialManager::onError);
     QObject::connect(m_autoDetectTimer, &QTimer::timeout,
                      this, &SerialManager::onAutoDetectTimer);
+    QObject::connect(m_bulkTimer, &QTimer::timeout,
+                     this, &SerialManager::onBulkTimer);
+    m_baudTimer->setSingleShot(true);
+    QObject::connect(m_baudTimer, &QTimer::timeout,
+                     this, &SerialManager::onBaudTimer);
+    m_calibrationTimer->setSingleShot(true);
+    QObject::connect(m_calibrationTimer, &QTimer::timeout,
+                     this, &SerialManager::onCalibrationTimer);
+    QObject::connect(m_healthTimer, &QTimer::timeout,
+                     this, &SerialManager::onHealthTimer);
+    QObject::connect(m_telemetryTimer, &QTimer::timeout,
+                     this, &SerialManager::onTelemetryTimer);
+
+    m_transportThread->start(QThread::TimeCriticalPriority);
+    m_scheduler->start();
 }
 
 SerialManager::~SerialManager()
 {
     disconnect();
+
+    // The dispatch thread sends through us, so it goes first
+    delete m_scheduler;
+    m_scheduler = nullptr;
+
+    m_transportThread->quit();
+    m_transportThread->wait();
+    delete m_transport;
 }
 
 QStringList SerialManager::availablePorts() const
@@ -37,7 +74,7 @@ QStringList SerialManager::availablePorts() const
 
 bool SerialManager::connect(const QString& portName)
 {
-    if (m_port->isOpen()) {
+    if (isConnected()) {
         disconnect();
     }
 
@@ -47,17 +84,26 @@ bool SerialManager::connect(const QString& portName)
     // Detect board type before connecting
     m_boardType = detectBoardType(actualPortName);
 
-    m_port->setPortName(actualPortName);
-    m_port->setBaudRate(BAUD_RATE);
-    m_port->setDataBits(QSerialPort::Data8);
-    m_port->setParity(QSerialPort::NoParity);
-    m_port->setStopBits(QSerialPort::OneStop);
-    m_port->setFlowControl(QSerialPort::NoFlowControl);
-
     m_state = ConnectionState::Connecting;
     emit connectionStateChanged(m_state);
 
-    if (m_port->open(QIODevice::ReadWrite)) {
+    // Open on the transport thread, which owns the port
+    bool opened = false;
+    QString errorString;
+    const PacingProfile pacing = pacingProfile(m_boardType, BAUD_RATE);
+    QMetaObject::invokeMethod(m_transport, [&]() {
+        opened = m_transport->open(actualPortName, BAUD_RATE, pacing);
+        if (!opened) {
+            errorString = m_transport->errorString();
+        }
+    }, Qt::BlockingQueuedConnection);
+
+    if (opened) {
+        m_portName = actualPortName;
+        m_baudRate = BAUD_RATE;
+        m_baudState = BaudState::Idle;
+        m_baudNegotiated = false;
+        m_baudCandidates.clear();
         m_state = ConnectionState::Connected;
         emit connectionStateChanged(m_state);
         emit connected();
@@ -68,26 +114,51 @@ bool SerialManager::connect(const QString& portName)
 
         // Send ping to verify device
         ping();
+        if (m_health.enabled) {
+            startLinkHealth();
+        }
+        if (m_telemetry.intervalMs > 0) {
+            m_telemetryTimer->start(m_telemetry.intervalMs);
+        }
         return true;
     } else {
         m_state = ConnectionState::Error;
         emit connectionStateChanged(m_state);
-        emit connectionError(m_port->errorString());
-        qDebug() << "Failed to connect:" << m_port->errorString();
+        emit connectionError(errorString);
+        qDebug() << "Failed to connect:" << errorString;
         return false;
     }
 }
 
 void SerialManager::disconnect()
 {
+    m_scheduler->clear();
+    if (m_calibration.active) {
+        finishLatencyCalibration(true);
+    }
+    // Latency belongs to the connection; the next one may be another board
+    m_calibration.result = LatencyCalibration();
+    applyLatencyCompensation();
+    m_healthTimer->stop();
+    m_health.awaiting = false;
+    m_health.status.monitoring = false;
+    m_telemetryTimer->stop();
+    m_telemetry.unanswered = 0;
+    m_telemetry.supported = false;
+    m_telemetry.last = DeviceTelemetry();
     m_autoDetectTimer->stop();
-
-    if (m_port->isOpen()) {
-        m_port->close();
+    m_baudTimer->stop();
+    m_baudState = BaudState::Idle;
+    if (m_bulk.active) {
+        finishBankUpload(false);
     }
 
-    m_rxBuffer.clear();
-    m_inSysEx = false;
+    QMetaObject::invokeMethod(m_transport, [this]() {
+        m_transport->close();
+    }, Qt::BlockingQueuedConnection);
+
+    m_portName.clear();
+    m_rxParser.reset();
     m_state = ConnectionState::Disconnected;
     emit connectionStateChanged(m_state);
     emit disconnected();
@@ -95,12 +166,36 @@ void SerialManager::disconnect()
 
 bool SerialManager::isConnected() const
 {
-    return m_port->isOpen();
+    return m_transport->isOpen();
 }
 
 QString SerialManager::connectedPort() const
 {
-    return m_port->isOpen() ? m_port->portName() : QString();
+    return isConnected() ? m_portName : QString();
+}
+
+void SerialManager::setWriteCoalescing(int flushBytes, int maxLatencyMs)
+{
+    m_transport->setCoalescing(flushBytes, maxLatencyMs);
+}
+
+void SerialManager::setRunningStatusEnabled(bool enabled)
+{
+    m_transport->setRunningStatusEnabled(enabled);
+}
+
+void SerialManager::setControllerThinning(bool enabled, int maxRateHz)
+{
+    m_transport->setControllerThinning(enabled, maxRateHz);
+}
+
+void SerialManager::setEchoTarget(MIDIManager* midi)
+{
+    // Blocking, so once this returns with nullptr no echo is still running
+    // on the transport thread and the target can be destroyed
+    QMetaObject::invokeMethod(m_transport, [this, midi]() {
+        m_transport->setEchoTarget(midi);
+    }, Qt::BlockingQueuedConnection);
 }
 
 // =============================================================================
@@ -109,98 +204,187 @@ QString SerialManager::connectedPort() const
 
 void SerialManager::sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity)
 {
-    std::vector<uint8_t> data = {
+    sendMidi(MidiMessage::make(
         static_cast<uint8_t>(0x90 | (channel & 0x0F)),
         static_cast<uint8_t>(note & 0x7F),
-        static_cast<uint8_t>(velocity & 0x7F)
-    };
-    sendRawMIDI(data);
+        static_cast<uint8_t>(velocity & 0x7F)));
 }
 
 void SerialManager::sendNoteOff(uint8_t channel, uint8_t note, uint8_t velocity)
 {
-    std::vector<uint8_t> data = {
+    sendMidi(MidiMessage::make(
         static_cast<uint8_t>(0x80 | (channel & 0x0F)),
         static_cast<uint8_t>(note & 0x7F),
-        static_cast<uint8_t>(velocity & 0x7F)
-    };
-    sendRawMIDI(data);
+        static_cast<uint8_t>(velocity & 0x7F)));
 }
 
 void SerialManager::sendControlChange(uint8_t channel, uint8_t cc, uint8_t value)
 {
-    std::vector<uint8_t> data = {
+    sendMidi(MidiMessage::make(
         static_cast<uint8_t>(0xB0 | (channel & 0x0F)),
         static_cast<uint8_t>(cc & 0x7F),
-        static_cast<uint8_t>(value & 0x7F)
-    };
-    sendRawMIDI(data);
+        static_cast<uint8_t>(value & 0x7F)));
 }
 
 void SerialManager::sendProgramChange(uint8_t channel, uint8_t program)
 {
-    std::vector<uint8_t> data = {
+    sendMidi(MidiMessage::make(
         static_cast<uint8_t>(0xC0 | (channel & 0x0F)),
-        static_cast<uint8_t>(program & 0x7F)
-    };
-    sendRawMIDI(data);
+        static_cast<uint8_t>(program & 0x7F)));
 }
 
 void SerialManager::sendPitchBend(uint8_t channel, uint16_t value)
 {
-    std::vector<uint8_t> data = {
+    sendMidi(MidiMessage::make(
         static_cast<uint8_t>(0xE0 | (channel & 0x0F)),
-        static_cast<uint8_t>(value & 0x7F),         // LSB
-        static_cast<uint8_t>((value >> 7) & 0x7F)   // MSB
-    };
-    sendRawMIDI(data);
+        static_cast<uint8_t>(value & 0x7F),          // LSB
+        static_cast<uint8_t>((value >> 7) & 0x7F))); // MSB
+}
+
+bool SerialManager::sendMidi(const MidiMessage& message)
+{
+    if (!isConnected() || message.isEmpty()) {
+        return false;
+    }
+
+    if (!m_transport->enqueue(message)) {
+        qWarning() << "Serial TX ring full - message dropped";
+        return false;
+    }
+    return true;
+}
+
+bool SerialManager::sendRawSysEx(const SysExMessage& message)
+{
+    if (!isConnected() || message.isEmpty()) {
+        return false;
+    }
+
+    if (!m_transport->enqueue(message)) {
+        qWarning() << "Serial TX ring full - SysEx dropped";
+        return false;
+    }
+    return true;
+}
+
+bool SerialManager::scheduleMidi(const MidiMessage& message, qint64 dueUs)
+{
+    return isConnected() && m_scheduler->schedule(message, dueUs);
+}
+
+bool SerialManager::scheduleSysEx(const SysExMessage& message, qint64 dueUs)
+{
+    return isConnected() && m_scheduler->schedule(message, dueUs);
+}
+
+bool SerialManager::sendTimed(const MidiMessage& message, qint64 sendAtUs)
+{
+    if (!isConnected() || message.isEmpty()) {
+        return false;
+    }
+
+    if (!m_transport->enqueue(message, sendAtUs)) {
+        qWarning() << "Serial TX ring full - scheduled message dropped";
+        return false;
+    }
+    return true;
 }
 
-void SerialManager::sendRawMIDI(const std::vector<uint8_t>& data)
+bool SerialManager::sendTimed(const SysExMessage& message, qint64 sendAtUs)
 {
-    if (!m_port->isOpen() || data.empty()) {
+    if (!isConnected() || message.isEmpty()) {
+        return false;
+    }
+
+    if (!m_transport->enqueue(message, sendAtUs)) {
+        qWarning() << "Serial TX ring full - scheduled SysEx dropped";
+        return false;
+    }
+    return true;
+}
+
+void SerialManager::enqueue(const QByteArray& message)
+{
+    if (!isConnected() || message.isEmpty()) {
         return;
     }
 
-    QByteArray bytes(reinterpret_cast<const char*>(data.data()),
-                     static_cast<int>(data.size()));
-    m_port->write(bytes);
+    if (!m_transport->enqueue(message)) {
+        qWarning() << "Serial TX ring full - message dropped";
+    }
 }
 
 // =============================================================================
 // SysEx Commands
 // =============================================================================
 
-void SerialManager::sendSysEx(const std::vector<uint8_t>& data)
+QByteArray SerialManager::buildSysEx(const std::vector<uint8_t>& data)
 {
-    if (!m_port->isOpen()) {
-        return;
-    }
-
     // Build complete SysEx message: F0 7D 00 <data...> F7
-    std::vector<uint8_t> sysex;
-    sysex.reserve(data.size() + 4);
-    sysex.push_back(0xF0);
-    sysex.push_back(SysEx::MANUFACTURER_ID);
-    sysex.push_back(SysEx::DEVICE_ID);
-    sysex.insert(sysex.end(), data.begin(), data.end());
-    sysex.push_back(0xF7);
-
-    sendRawMIDI(sysex);
+    QByteArray sysex;
+    sysex.reserve(static_cast<int>(data.size()) + 4);
+    sysex.append(static_cast<char>(0xF0));
+    sysex.append(static_cast<char>(SysEx::MANUFACTURER_ID));
+    sysex.append(static_cast<char>(SysEx::DEVICE_ID));
+    sysex.append(reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size()));
+    sysex.append(static_cast<char>(0xF7));
+    return sysex;
 }
 
-void SerialManager::sendFMPatchToChannel(uint8_t channel, const FMPatch& patch)
+QByteArray SerialManager::buildFMPatchLoad(uint8_t channel, const FMPatch& patch)
 {
-    if (channel >= 6) return;
-
     auto patchBytes = patch.toBytes();
     std::vector<uint8_t> data;
     data.reserve(44);
     data.push_back(SysEx::CMD_LOAD_FM_PATCH);
     data.push_back(channel);
     data.insert(data.end(), patchBytes.begin(), patchBytes.end());
+    return buildSysEx(data);
+}
 
-    sendSysEx(data);
+QByteArray SerialManager::buildFMParameter(uint8_t channel, int opIndex, FMParam param, uint8_t value)
+{
+    if (param != FMParam::Algorithm && param != FMParam::Feedback &&
+        (opIndex < 0 || opIndex >= 4)) {
+        return QByteArray();
+    }
+
+    // Parameters the firmware already handles as CCs (the same numbers it
+    // echoes back) go out as 3-byte CCs; everything else as a 7-byte SysEx
+    int cc = -1;
+    switch (param) {
+        case FMParam::Algorithm: cc = 14; break;
+        case FMParam::Feedback: cc = 15; break;
+        case FMParam::Tl: cc = 16 + opIndex; break;
+        default: break;
+    }
+
+    if (cc >= 0) {
+        QByteArray msg(3, 0);
+        msg[0] = static_cast<char>(0xB0 | (channel & 0x0F));
+        msg[1] = static_cast<char>(cc);
+        msg[2] = static_cast<char>(value & 0x7F);
+        return msg;
+    }
+
+    return buildSysEx({
+        SysEx::CMD_SET_FM_PARAM,
+        channel,
+        static_cast<uint8_t>(FMPatch::byteOffset(opIndex, param)),
+        static_cast<uint8_t>(value & 0x7F)
+    });
+}
+
+void SerialManager::sendSysEx(const std::vector<uint8_t>& data)
+{
+    enqueue(buildSysEx(data));
+}
+
+void SerialManager::sendFMPatchToChannel(uint8_t channel, const FMPatch& patch)
+{
+    if (channel >= 6) return;
+
+    enqueue(buildFMPatchLoad(channel, patch));
     qDebug() << "Sent FM patch to channel" << channel;
 }
 
@@ -219,6 +403,40 @@ void SerialManager::sendFMPatchToSlot(uint8_t slot, const FMPatch& patch)
     qDebug() << "Stored FM patch to slot" << slot;
 }
 
+void SerialManager::sendFMParameter(uint8_t channel, int opIndex, FMParam param, uint8_t value)
+{
+    if (channel >= 6) return;
+
+    enqueue(buildFMParameter(channel, opIndex, param, value));
+}
+
+// =============================================================================
+// Live Edit (latest value wins)
+// =============================================================================
+
+void SerialManager::queueLivePatch(uint8_t channel, const FMPatch& patch)
+{
+    if (channel >= 6 || !isConnected()) return;
+
+    m_transport->enqueueLatest(channel, SerialTransport::LIVE_KEY_PATCH,
+                               buildFMPatchLoad(channel, patch));
+}
+
+void SerialManager::queueLiveParameter(uint8_t channel, int opIndex, FMParam param, uint8_t value)
+{
+    if (channel >= 6 || !isConnected()) return;
+
+    QByteArray msg = buildFMParameter(channel, opIndex, param, value);
+    if (!msg.isEmpty()) {
+        m_transport->enqueueLatest(channel, FMPatch::byteOffset(opIndex, param), std::move(msg));
+    }
+}
+
+void SerialManager::setLiveEditMaxRate(int hz)
+{
+    m_transport->setLiveEditMaxRate(hz);
+}
+
 void SerialManager::sendPSGEnvelope(uint8_t channel, const PSGEnvelope& env)
 {
     if (channel >= 4) return;
@@ -250,6 +468,21 @@ void SerialManager::recallPatchToChannel(uint8_t channel, uint8_t slot)
     qDebug() << "Recalled slot" << slot << "to channel" << channel;
 }
 
+bool SerialManager::recallPatchThenSend(uint8_t channel, uint8_t slot, const MidiMessage& message)
+{
+    if (!isConnected() || channel >= 6 || slot >= 16 || message.isEmpty()) {
+        return false;
+    }
+
+    // Both go through the channel FIFO as one entry: nothing can come
+    // between them, and neither waits behind bulk SysEx
+    if (!m_transport->enqueueAfterRecall(channel, slot, message)) {
+        qWarning() << "Serial TX ring full - patch recall dropped";
+        return false;
+    }
+    return true;
+}
+
 void SerialManager::requestPatchDump(uint8_t slot)
 {
     if (slot >= 16) return;
@@ -269,6 +502,14 @@ void SerialManager::requestAllPatches()
     sendSysEx(data);
 }
 
+void SerialManager::requestTelemetry()
+{
+    std::vector<uint8_t> data = {
+        SysEx::CMD_REQUEST_TELEMETRY
+    };
+    sendSysEx(data);
+}
+
 void SerialManager::setSynthMode(SynthMode mode)
 {
     std::vector<uint8_t> data = {
@@ -288,73 +529,791 @@ void SerialManager::ping()
 }
 
 // =============================================================================
-// Receive Handling
+// Latency Calibration
 // =============================================================================
 
-void SerialManager::onReadyRead()
-{
-    QByteArray data = m_port->readAll();
-
-    for (char c : data) {
-        uint8_t byte = static_cast<uint8_t>(c);
-
-        if (byte == 0xF0) {
-            // Start of SysEx
-            m_inSysEx = true;
-            m_rxBuffer.clear();
-            m_rxBuffer.append(c);
-        } else if (byte == 0xF7 && m_inSysEx) {
-            // End of SysEx
-            m_rxBuffer.append(c);
-            processSysEx(m_rxBuffer);
-            m_rxBuffer.clear();
-            m_inSysEx = false;
-        } else if (m_inSysEx) {
-            // Middle of SysEx
-            m_rxBuffer.append(c);
-        } else if (byte & 0x80) {
-            // Status byte (new MIDI message)
-            m_midiStatus = byte;
-            m_midiDataCount = 0;
-
-            // Determine expected data bytes based on message type
-            uint8_t msgType = byte & 0xF0;
-            if (msgType == 0xC0 || msgType == 0xD0) {
-                // Program Change, Channel Pressure: 1 data byte
-                m_midiExpectedBytes = 1;
-            } else if (msgType >= 0x80 && msgType <= 0xE0) {
-                // Note Off/On, Poly Pressure, CC, Pitch Bend: 2 data bytes
-                m_midiExpectedBytes = 2;
+QString LatencyCalibration::toText() const
+{
+    auto ms = [](double us) { return QString::number(us / 1000.0, 'f', 3); };
+    QString board = boardType == BoardType::Teensy ? "Teensy"
+                  : boardType == BoardType::Arduino ? "Arduino" : "Unknown";
+
+    QStringList lines;
+    lines << "# Genesis Engine latency calibration"
+          << "port=" + port
+          << "board=" + board
+          << QString("baud=%1").arg(baudRate)
+          << QString("samples=%1").arg(samples)
+          << QString("lost=%1").arg(lost)
+          << "rtt_min_ms=" + ms(rttMinUs)
+          << "rtt_median_ms=" + ms(rttMedianUs)
+          << "rtt_mean_ms=" + ms(rttMeanUs)
+          << "rtt_max_ms=" + ms(rttMaxUs)
+          << "one_way_ms=" + ms(oneWayUs)
+          << "jitter_ms=" + ms(jitterUs)
+          << "# DAW track delay for live MIDI through the app (negative = early)"
+          << "track_delay_ms=" + ms(-oneWayUs);
+    return lines.join('\n') + "\n";
+}
+
+bool SerialManager::startLatencyCalibration(int pings)
+{
+    // Baud negotiation and bank uploads would interleave with the pings
+    if (!isConnected() || m_calibration.active || m_bulk.active ||
+        m_baudState != BaudState::Idle || pings <= 0) {
+        return false;
+    }
+
+    m_calibration = Calibration();
+    m_calibration.active = true;
+    m_health.awaiting = false;      // Its reply would be taken for ours
+    m_calibration.total = pings;
+    m_calibration.rttUs.reserve(pings);
+    qDebug() << "Latency calibration:" << pings << "pings on" << m_portName;
+    sendCalibrationPing();
+    return true;
+}
+
+void SerialManager::setLatencyCompensation(bool enabled)
+{
+    m_latencyCompensation = enabled;
+    applyLatencyCompensation();
+}
+
+void SerialManager::applyLatencyCompensation()
+{
+    const LatencyCalibration& result = m_calibration.result;
+    m_scheduler->setLatencyCompensation(m_latencyCompensation && result.valid
+                                        ? qRound64(result.oneWayUs) : 0);
+}
+
+void SerialManager::sendCalibrationPing()
+{
+    m_calibration.awaiting = true;
+    m_calibration.sent++;
+    m_calibration.requestedUs = m_transport->clockUs();
+    ping();
+    m_calibrationTimer->start(CALIBRATION_TIMEOUT_MS);
+}
+
+void SerialManager::handleCalibrationReply()
+{
+    m_calibrationTimer->stop();
+    m_calibration.awaiting = false;
+
+    // The first identity after connecting may start baud negotiation,
+    // which changes what we're measuring
+    if (m_baudState != BaudState::Idle) {
+        finishLatencyCalibration(true);
+        return;
+    }
+
+    // Timed from the write; from the queueing if the transport hasn't
+    // stamped this ping yet
+    qint64 sentUs = qMax(m_transport->lastPingWrittenUs(), m_calibration.requestedUs);
+    qint64 rttUs = m_rxTimestampUs - sentUs;
+    if (rttUs > 0) {
+        m_calibration.rttUs.push_back(rttUs);
+    } else {
+        m_calibration.lost++;
+    }
+
+    emit calibrationProgress(m_calibration.sent, m_calibration.total);
+    if (m_calibration.sent >= m_calibration.total) {
+        finishLatencyCalibration(false);
+    } else {
+        m_calibrationTimer->start(CALIBRATION_SPACING_MS);
+    }
+}
+
+void SerialManager::onCalibrationTimer()
+{
+    if (!m_calibration.active) {
+        return;
+    }
+
+    if (m_calibration.awaiting) {
+        // No reply in time
+        m_calibration.awaiting = false;
+        m_calibration.lost++;
+        emit calibrationProgress(m_calibration.sent, m_calibration.total);
+    }
+
+    if (m_calibration.sent >= m_calibration.total) {
+        finishLatencyCalibration(false);
+    } else {
+        sendCalibrationPing();
+    }
+}
+
+void SerialManager::finishLatencyCalibration(bool aborted)
+{
+    m_calibrationTimer->stop();
+    m_calibration.active = false;
+    m_calibration.awaiting = false;
+
+    std::vector<qint64>& rtts = m_calibration.rttUs;
+    LatencyCalibration result;
+    result.port = m_portName;
+    result.boardType = m_boardType;
+    result.baudRate = m_baudRate;
+    result.samples = static_cast<int>(rtts.size());
+    result.lost = m_calibration.lost;
+
+    // At least half the pings must have come back
+    if (!aborted && result.samples > 0 && result.samples * 2 >= m_calibration.total) {
+        std::sort(rtts.begin(), rtts.end());
+        const size_t n = rtts.size();
+        result.rttMinUs = static_cast<double>(rtts.front());
+        result.rttMaxUs = static_cast<double>(rtts.back());
+        result.rttMedianUs = (n % 2) ? static_cast<double>(rtts[n / 2])
+                                     : (rtts[n / 2 - 1] + rtts[n / 2]) / 2.0;
+        double sum = 0.0;
+        for (qint64 rtt : rtts) {
+            sum += static_cast<double>(rtt);
+        }
+        result.rttMeanUs = sum / static_cast<double>(n);
+
+        // Symmetric link assumption: half the round trip each way
+        result.oneWayUs = result.rttMedianUs / 2.0;
+        double variance = 0.0;
+        for (qint64 rtt : rtts) {
+            double deviation = (static_cast<double>(rtt) - result.rttMeanUs) / 2.0;
+            variance += deviation * deviation;
+        }
+        result.jitterUs = std::sqrt(variance / static_cast<double>(n));
+        result.valid = true;
+    }
+
+    m_calibration.result = result;
+    applyLatencyCompensation();
+
+    if (result.valid) {
+        qDebug() << "Latency calibration:" << result.samples << "samples," << result.lost
+                 << "lost, one-way" << result.oneWayUs << "us, jitter" << result.jitterUs << "us";
+    } else {
+        qWarning() << "Latency calibration failed:" << result.samples << "of"
+                   << m_calibration.total << "pings answered" << (aborted ? "(aborted)" : "");
+    }
+    emit calibrationFinished(result);
+}
+
+// =============================================================================
+// Link Health
+// =============================================================================
+
+QString LinkHealth::toText() const
+{
+    auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 1); };
+    QString text = QString("RTT p50 %1, p95 %2, p99 %3, max %4 ms; %5 of %6 pings lost; TX queue %7")
+        .arg(ms(rttP50Us), ms(rttP95Us), ms(rttP99Us), ms(rttMaxUs))
+        .arg(pingsLost).arg(pingsSent).arg(txQueueDepth);
+    if (timedWritten > 0) {
+        text += QString("; scheduled output %1 of %2 late, max %3 ms")
+            .arg(timedLate).arg(timedWritten).arg(ms(timedMaxLatenessUs));
+    }
+    if (degraded) {
+        text += " - degraded: " + reason;
+    }
+    return text;
+}
+
+void SerialManager::setLinkHealthMonitor(bool enabled, int intervalMs)
+{
+    m_health.intervalMs = qMax(HEALTH_MIN_INTERVAL_MS, intervalMs);
+    if (enabled && m_health.enabled && m_healthTimer->isActive()) {
+        m_healthTimer->setInterval(m_health.intervalMs);
+        return;
+    }
+
+    m_health.enabled = enabled;
+    if (enabled && isConnected()) {
+        startLinkHealth();
+    } else {
+        m_healthTimer->stop();
+        m_health.awaiting = false;
+        m_health.status.monitoring = false;
+    }
+}
+
+void SerialManager::startLinkHealth()
+{
+    m_health.awaiting = false;
+    m_health.replyOverdue = false;
+    m_health.consecutiveLost = 0;
+    m_health.consecutiveSlow = 0;
+    m_health.droppedAtStart = m_transport->droppedMessages();
+    m_health.droppedLastTick = m_health.droppedAtStart;
+    m_health.rtts.reset();
+    m_health.status = LinkHealth();
+    m_health.status.monitoring = true;
+    m_healthTimer->start(m_health.intervalMs);
+}
+
+void SerialManager::onHealthTimer()
+{
+    if (!isConnected()) {
+        m_healthTimer->stop();
+        return;
+    }
+
+    // Calibration sends its own pings, and negotiation and uploads hold the
+    // link; round trips taken meanwhile say nothing about its health
+    if (m_calibration.active || m_bulk.active || m_baudState != BaudState::Idle) {
+        m_health.awaiting = false;
+        return;
+    }
+
+    if (m_health.awaiting) {
+        // No reply within one interval
+        m_health.awaiting = false;
+        m_health.replyOverdue = true;
+        m_health.status.pingsLost++;
+        m_health.consecutiveLost++;
+        updateLinkHealth();
+    }
+
+    m_health.awaiting = true;
+    m_health.requestedUs = m_transport->clockUs();
+    m_health.status.pingsSent++;
+    ping();
+}
+
+void SerialManager::handleHealthReply()
+{
+    // Same timing as calibration. A reply that beat our ping to the wire
+    // answers someone else's ping, so keep waiting.
+    qint64 sentUs = qMax(m_transport->lastPingWrittenUs(), m_health.requestedUs);
+    qint64 rttUs = m_rxTimestampUs - sentUs;
+    if (rttUs <= 0) {
+        // Most likely the overdue reply, arriving before this ping went out
+        m_health.replyOverdue = false;
+        return;
+    }
+
+    // Identity replies carry no sequence number. After a timeout the first
+    // reply may be the overdue one, which would give this ping a round trip
+    // that is too short; it is discarded, and so is this ping's sample.
+    m_health.awaiting = false;
+    if (m_health.replyOverdue) {
+        m_health.replyOverdue = false;
+        return;
+    }
+    m_health.consecutiveLost = 0;
+
+    const qint64 baselineUs = m_health.status.baselineUs;
+    const qint64 slowUs = qMax(HEALTH_SLOW_FLOOR_US, baselineUs * HEALTH_SLOW_FACTOR);
+    m_health.consecutiveSlow = (baselineUs > 0 && rttUs > slowUs) ? m_health.consecutiveSlow + 1 : 0;
+
+    m_health.status.lastRttUs = rttUs;
+    m_health.rtts.add(rttUs);
+    updateLinkHealth();
+}
+
+void SerialManager::updateLinkHealth()
+{
+    LinkHealth& status = m_health.status;
+    const RttHistogram& rtts = m_health.rtts;
+    status.samples = rtts.count();
+    status.rttP50Us = rtts.percentile(0.50);
+    status.rttP95Us = rtts.percentile(0.95);
+    status.rttP99Us = rtts.percentile(0.99);
+    status.rttMaxUs = rtts.max();
+    if (status.samples >= HEALTH_MIN_SAMPLES &&
+        (status.baselineUs == 0 || status.rttP50Us < status.baselineUs)) {
+        status.baselineUs = status.rttP50Us;
+    }
+
+    status.txQueueDepth = m_transport->queuedMessages();
+    const quint64 dropped = m_transport->droppedMessages();
+    const quint64 newlyDropped = dropped - m_health.droppedLastTick;
+    m_health.droppedLastTick = dropped;
+    status.txDropped = dropped - m_health.droppedAtStart;
+    const OutputScheduler::Stats timed = m_scheduler->stats();
+    status.timedWritten = timed.written;
+    status.timedLate = timed.late;
+    status.timedMaxLatenessUs = timed.maxLatenessUs;
+
+    // Judged on the last few pings rather than the whole window, so the
+    // flag clears as soon as the link does
+    auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 1); };
+    QString reason;
+    if (m_health.consecutiveLost >= HEALTH_LOST_LIMIT) {
+        reason = QString("%1 pings in a row unanswered").arg(m_health.consecutiveLost);
+    } else if (m_health.consecutiveSlow >= HEALTH_SLOW_LIMIT) {
+        reason = QString("round trip %1 ms, normally %2 ms")
+            .arg(ms(status.lastRttUs), ms(status.baselineUs));
+    } else if (newlyDropped > 0) {
+        reason = QString("%1 messages dropped on a full TX ring").arg(newlyDropped);
+    } else if (status.txQueueDepth > HEALTH_QUEUE_LIMIT) {
+        reason = QString("%1 messages waiting to send").arg(status.txQueueDepth);
+    }
+
+    const bool degraded = !reason.isEmpty();
+    const bool changed = degraded != status.degraded;
+    status.degraded = degraded;
+    status.reason = reason;
+    if (changed && degraded) {
+        qWarning() << "Serial link degraded:" << status.toText();
+    } else if (changed) {
+        qDebug() << "Serial link recovered:" << status.toText();
+    }
+    emit linkHealthChanged(status);
+}
+
+// =============================================================================
+// Device Telemetry
+// =============================================================================
+
+QString DeviceTelemetry::toText() const
+{
+    auto delta = [](int increase) { return increase > 0 ? QString(" (+%1)").arg(increase) : QString(); };
+    return QString("loop %1 us avg, %2 us max; %3 FM + %4 PSG voices; %5 RX overflows%6, %7 SysEx dropped%8")
+        .arg(loopAvgUs).arg(loopMaxUs).arg(fmVoices).arg(psgVoices)
+        .arg(rxOverflows).arg(delta(rxOverflowsDelta))
+        .arg(sysexDropped).arg(delta(sysexDroppedDelta));
+}
+
+void SerialManager::setTelemetryInterval(int intervalMs)
+{
+    m_telemetry.intervalMs = intervalMs > 0 ? qMax(TELEMETRY_MIN_INTERVAL_MS, intervalMs) : 0;
+    m_telemetry.unanswered = 0;
+    if (m_telemetry.intervalMs > 0 && isConnected()) {
+        m_telemetryTimer->start(m_telemetry.intervalMs);
+    } else {
+        m_telemetryTimer->stop();
+    }
+}
+
+void SerialManager::onTelemetryTimer()
+{
+    if (!isConnected()) {
+        m_telemetryTimer->stop();
+        return;
+    }
+
+    // Keep the link quiet while round trips are measured or the rate is in flux
+    if (m_calibration.active || m_baudState != BaudState::Idle) {
+        return;
+    }
+
+    // Older firmware ignores the request; a device that once answered
+    // keeps being asked, since silence then means it's struggling
+    if (!m_telemetry.supported && m_telemetry.unanswered >= TELEMETRY_GIVE_UP) {
+        m_telemetryTimer->stop();
+        qDebug() << "Device does not report telemetry; polling stopped";
+        return;
+    }
+
+    m_telemetry.unanswered++;
+    requestTelemetry();
+}
+
+void SerialManager::handleTelemetry(const uint8_t* data)
+{
+    const uint16_t rxOverflowsRaw = static_cast<uint16_t>(SysEx::decode7(data + 6, 2));
+    const uint16_t sysexDroppedRaw = static_cast<uint16_t>(SysEx::decode7(data + 8, 2));
+
+    DeviceTelemetry& telemetry = m_telemetry.last;
+    if (!m_telemetry.supported) {
+        // First reply: the counters so far predate this connection
+        telemetry = DeviceTelemetry();
+        telemetry.rxOverflows = rxOverflowsRaw;
+        telemetry.sysexDropped = sysexDroppedRaw;
+    } else {
+        // 14-bit counters wrap; the difference modulo 2^14 is the increase
+        telemetry.rxOverflowsDelta = (rxOverflowsRaw - m_telemetry.rxOverflowsRaw) & 0x3FFF;
+        telemetry.sysexDroppedDelta = (sysexDroppedRaw - m_telemetry.sysexDroppedRaw) & 0x3FFF;
+        telemetry.rxOverflows += telemetry.rxOverflowsDelta;
+        telemetry.sysexDropped += telemetry.sysexDroppedDelta;
+    }
+    m_telemetry.rxOverflowsRaw = rxOverflowsRaw;
+    m_telemetry.sysexDroppedRaw = sysexDroppedRaw;
+
+    telemetry.valid = true;
+    telemetry.loopAvgUs = static_cast<int>(SysEx::decode7(data, 3));
+    telemetry.loopMaxUs = static_cast<int>(SysEx::decode7(data + 3, 3));
+    telemetry.fmVoices = data[10] & 0x7F;
+    telemetry.psgVoices = data[11] & 0x7F;
+
+    if (!m_telemetry.supported) {
+        qDebug() << "Device telemetry:" << telemetry.toText();
+    } else if (telemetry.rxOverflowsDelta > 0 || telemetry.sysexDroppedDelta > 0) {
+        qWarning() << "Device overrun:" << telemetry.toText();
+    }
+    m_telemetry.supported = true;
+    m_telemetry.unanswered = 0;
+    emit telemetryReceived(telemetry);
+}
+
+// =============================================================================
+// Active Notes / Panic
+// =============================================================================
+
+int SerialManager::panic()
+{
+    if (!isConnected()) {
+        return 0;
+    }
+
+    // Scheduled notes would restart what the panic is about to stop
+    int unscheduled = m_scheduler->clear();
+
+    int released = 0;
+    QMetaObject::invokeMethod(m_transport, [&]() {
+        released = m_transport->releaseActiveNotes();
+    }, Qt::BlockingQueuedConnection);
+
+    // A DAW can play a Teensy over USB MIDI without going through us, so
+    // the bitmap isn't the whole story there; USB isn't baud-limited either
+    if (m_boardType == BoardType::Teensy) {
+        for (uint8_t ch = 0; ch < 16; ch++) {
+            sendControlChange(ch, 120, 0);   // All Sound Off
+            sendControlChange(ch, 123, 0);   // All Notes Off
+        }
+    }
+
+    qDebug() << "Panic: released" << released << "notes, dropped" << unscheduled << "scheduled events";
+    return released;
+}
+
+void SerialManager::setStuckNoteLimit(int limitMs)
+{
+    m_transport->setStuckNoteLimit(limitMs);
+}
+
+void SerialManager::notifyInputClosed(int sourceId)
+{
+    m_transport->notifySourceClosed(sourceId);
+}
+
+// =============================================================================
+// Bank Upload
+// =============================================================================
+
+bool SerialManager::uploadBank(const std::vector<FMPatch>& patches)
+{
+    if (!isConnected() || m_bulk.active || patches.empty()) {
+        return false;
+    }
+
+    m_bulk = BulkUpload();
+    m_bulk.active = true;
+    m_bulk.window = (m_boardType == BoardType::Teensy) ? BULK_WINDOW_TEENSY : BULK_WINDOW_AVR;
+
+    int count = qMin(static_cast<int>(patches.size()), 16);
+    m_bulk.frames.resize(count);
+    for (int slot = 0; slot < count; slot++) {
+        auto patchBytes = patches[slot].toBytes();
+        BulkFrame& frame = m_bulk.frames[slot];
+        frame.payload.reserve(1 + 42);
+        frame.payload.append(static_cast<char>(slot));
+        frame.payload.append(reinterpret_cast<const char*>(patchBytes.data()),
+                             static_cast<int>(patchBytes.size()));
+        frame.checksum = SysEx::checksum(
+            reinterpret_cast<const uint8_t*>(frame.payload.constData()), frame.payload.size());
+    }
+
+    m_bulk.clock.start();
+    fillBulkWindow();
+    m_bulkTimer->start(BULK_ACK_TIMEOUT_MS / 5);
+    return true;
+}
+
+void SerialManager::cancelBankUpload()
+{
+    if (m_bulk.active) {
+        finishBankUpload(false);
+    }
+}
+
+void SerialManager::fillBulkWindow()
+{
+    int total = static_cast<int>(m_bulk.frames.size());
+    while (m_bulk.inFlight.size() < m_bulk.window && m_bulk.nextSlot < total) {
+        sendBulkFrame(m_bulk.nextSlot++);
+    }
+}
+
+void SerialManager::sendBulkFrame(int slot)
+{
+    BulkFrame& frame = m_bulk.frames[slot];
+
+    // Fresh sequence per transmission so a late ack for an earlier attempt
+    // can't be mistaken for the retransmit
+    uint8_t seq = m_bulk.nextSeq;
+    m_bulk.nextSeq = (m_bulk.nextSeq + 1) & 0x7F;
+    m_bulk.inFlight.insert(seq, slot);
+
+    // F0 7D 00 14 <seq> <slot> <42 bytes> <checksum> F7
+    std::vector<uint8_t> data;
+    data.reserve(2 + frame.payload.size() + 1);
+    data.push_back(SysEx::CMD_BULK_FM_FRAME);
+    data.push_back(seq);
+    data.insert(data.end(), frame.payload.begin(), frame.payload.end());
+    data.push_back(frame.checksum);
+
+    QByteArray message = buildSysEx(data);
+    m_bulk.bytesSent += message.size();
+    frame.sentAtMs = m_bulk.clock.elapsed();
+    frame.attempts++;
+    enqueue(message);
+}
+
+void SerialManager::handleBulkAck(uint8_t seq, uint8_t status, uint8_t checksum)
+{
+    if (!m_bulk.active) return;
+
+    auto it = m_bulk.inFlight.find(seq);
+    if (it == m_bulk.inFlight.end()) {
+        return;  // Stale ack for a frame already retransmitted
+    }
+    int slot = it.value();
+    m_bulk.inFlight.erase(it);
+    m_bulk.anyAck = true;
+
+    BulkFrame& frame = m_bulk.frames[slot];
+    if (status == SysEx::BULK_OK && checksum == frame.checksum) {
+        frame.acked = true;
+        m_bulk.ackedCount++;
+        emit bankUploadProgress(m_bulk.ackedCount, static_cast<int>(m_bulk.frames.size()));
+    } else if (frame.attempts < BULK_MAX_ATTEMPTS) {
+        qDebug() << "Bulk frame for slot" << slot << "rejected, retransmitting";
+        sendBulkFrame(slot);
+    } else {
+        qWarning() << "Bulk frame for slot" << slot << "failed after" << frame.attempts << "attempts";
+        finishBankUpload(false);
+        return;
+    }
+
+    if (m_bulk.ackedCount == static_cast<int>(m_bulk.frames.size())) {
+        finishBankUpload(true);
+    } else {
+        fillBulkWindow();
+    }
+}
+
+void SerialManager::onBulkTimer()
+{
+    if (!m_bulk.active) {
+        m_bulkTimer->stop();
+        return;
+    }
+
+    // Collect first - retransmitting changes inFlight
+    qint64 now = m_bulk.clock.elapsed();
+    QList<uint8_t> expired;
+    for (auto it = m_bulk.inFlight.constBegin(); it != m_bulk.inFlight.constEnd(); ++it) {
+        if (now - m_bulk.frames[it.value()].sentAtMs >= BULK_ACK_TIMEOUT_MS) {
+            expired.append(it.key());
+        }
+    }
+
+    for (uint8_t seq : expired) {
+        int slot = m_bulk.inFlight.take(seq);
+        BulkFrame& frame = m_bulk.frames[slot];
+
+        if (frame.attempts >= BULK_MAX_ATTEMPTS) {
+            if (!m_bulk.anyAck) {
+                // Firmware predates bulk frames - fall back to plain stores,
+                // which the device can't confirm
+                qWarning() << "Device did not acknowledge bulk frames, using unacknowledged upload";
+                for (const BulkFrame& f : m_bulk.frames) {
+                    std::vector<uint8_t> data;
+                    data.reserve(1 + f.payload.size());
+                    data.push_back(SysEx::CMD_STORE_FM_PATCH);
+                    data.insert(data.end(), f.payload.begin(), f.payload.end());
+                    QByteArray message = buildSysEx(data);
+                    m_bulk.bytesSent += message.size();
+                    enqueue(message);
+                }
+                m_bulk.unverifiedCount = static_cast<int>(m_bulk.frames.size());
+                finishBankUpload(true);
             } else {
-                // System messages - ignore for now
-                m_midiExpectedBytes = 0;
+                qWarning() << "Bulk frame for slot" << slot << "timed out after" << frame.attempts << "attempts";
+                finishBankUpload(false);
             }
-        } else if (m_midiStatus && m_midiExpectedBytes > 0) {
-            // Data byte
-            if (m_midiDataCount == 0) {
-                m_midiData1 = byte;
-                m_midiDataCount = 1;
-            } else {
-                // Second data byte - message complete
-                m_midiDataCount = 0;
+            return;
+        }
 
-                uint8_t msgType = m_midiStatus & 0xF0;
-                uint8_t channel = m_midiStatus & 0x0F;
+        sendBulkFrame(slot);
+    }
+}
 
-                if (msgType == 0xB0) {
-                    // Control Change - emit signal for UI update
-                    emit ccReceived(channel, m_midiData1, byte);
-                }
+void SerialManager::finishBankUpload(bool success)
+{
+    m_bulkTimer->stop();
+
+    qint64 elapsedMs = qMax<qint64>(1, m_bulk.clock.elapsed());
+    double bytesPerSecond = m_bulk.bytesSent * 1000.0 / elapsedMs;
+    int stored = m_bulk.ackedCount;
+    int unverified = m_bulk.unverifiedCount;
+    m_bulk.active = false;
+    m_bulk.inFlight.clear();
+
+    if (unverified > 0) {
+        qDebug() << "Bank upload sent without acknowledgement:"
+                 << unverified << "slots in" << elapsedMs << "ms,"
+                 << qRound(bytesPerSecond) << "bytes/s";
+    } else {
+        qDebug() << "Bank upload" << (success ? "complete:" : "failed:")
+                 << stored << "slots in" << elapsedMs << "ms,"
+                 << qRound(bytesPerSecond) << "bytes/s";
+    }
+    emit bankUploadFinished(success, stored, unverified, bytesPerSecond);
+}
+
+// =============================================================================
+// Baud Negotiation
+// =============================================================================
+
+void SerialManager::handleIdentityBaud(uint8_t baudMask)
+{
+    switch (m_baudState) {
+        case BaudState::Verifying:
+            // Device answered at the new rate
+            m_baudTimer->stop();
+            m_baudState = BaudState::Idle;
+            m_baudCandidates.clear();
+            qDebug() << "Serial link running at" << m_baudRate << "baud";
+            emit baudRateChanged(m_baudRate);
+            break;
+
+        case BaudState::Reverting:
+            // Both ends back at the base rate - try the next slower one
+            m_baudTimer->stop();
+            m_baudState = BaudState::Idle;
+            if (m_baudCandidates.isEmpty()) {
+                emit baudRateChanged(m_baudRate);
+            } else {
+                tryNextBaudRate();
             }
+            break;
 
-            // Handle 1-byte messages
-            if (m_midiExpectedBytes == 1 && m_midiDataCount == 1) {
-                m_midiDataCount = 0;
+        case BaudState::Idle:
+            // USB CDC ignores the baud rate, so only UART bridges benefit
+            if (m_baudNegotiated || m_boardType == BoardType::Teensy || baudMask == 0) {
+                break;
             }
-        }
+            m_baudNegotiated = true;
+            m_baudCandidates.clear();
+            if (baudMask & SysEx::BAUD_2M) m_baudCandidates.append({SysEx::BAUD_2M, 2000000});
+            if (baudMask & SysEx::BAUD_1M) m_baudCandidates.append({SysEx::BAUD_1M, 1000000});
+            if (baudMask & SysEx::BAUD_500K) m_baudCandidates.append({SysEx::BAUD_500K, 500000});
+            tryNextBaudRate();
+            break;
+
+        case BaudState::AwaitingAck:
+            break;
+    }
+}
 
-        // Always emit raw data for activity monitoring
-        emit midiDataReceived(QByteArray(1, c));
+void SerialManager::tryNextBaudRate()
+{
+    if (m_baudCandidates.isEmpty() || !isConnected()) {
+        return;
+    }
+
+    const auto& candidate = m_baudCandidates.first();
+    qDebug() << "Requesting baud switch to" << candidate.second;
+    sendSysEx({SysEx::CMD_SET_BAUD, candidate.first});
+    m_baudState = BaudState::AwaitingAck;
+    m_baudTimer->start(BAUD_ACK_TIMEOUT_MS);
+}
+
+void SerialManager::handleBaudAck(uint8_t code)
+{
+    if (m_baudState != BaudState::AwaitingAck || m_baudCandidates.isEmpty() ||
+        code != m_baudCandidates.first().first) {
+        return;
+    }
+
+    // The device switches right after sending the ack
+    m_baudTimer->stop();
+    if (!switchTransportBaud(m_baudCandidates.first().second)) {
+        qWarning() << "Host serial port rejected" << m_baudCandidates.first().second << "baud";
+        m_baudCandidates.removeFirst();
+        m_baudState = BaudState::Reverting;
+        m_baudFallbackPinged = false;
+        m_baudTimer->start(BAUD_DEVICE_REVERT_MS);
+        return;
+    }
+
+    m_baudState = BaudState::Verifying;
+    ping();
+    m_baudTimer->start(BAUD_VERIFY_TIMEOUT_MS);
+}
+
+void SerialManager::onBaudTimer()
+{
+    switch (m_baudState) {
+        case BaudState::AwaitingAck:
+            // Firmware didn't take the request; stay where we are
+            qWarning() << "Device did not acknowledge baud switch, staying at" << m_baudRate;
+            m_baudState = BaudState::Idle;
+            m_baudCandidates.clear();
+            break;
+
+        case BaudState::Verifying:
+            // No answer at the new rate - drop back and let the device time out too
+            qWarning() << "No response at" << m_baudRate << "baud, falling back to" << BAUD_RATE;
+            switchTransportBaud(BAUD_RATE);
+            m_baudCandidates.removeFirst();
+            m_baudState = BaudState::Reverting;
+            m_baudFallbackPinged = false;
+            m_baudTimer->start(BAUD_DEVICE_REVERT_MS);
+            break;
+
+        case BaudState::Reverting:
+            if (m_baudFallbackPinged) {
+                // Device is silent at the base rate as well
+                qWarning() << "Device not responding after baud fallback";
+                m_baudState = BaudState::Idle;
+                m_baudCandidates.clear();
+                emit baudRateChanged(m_baudRate);
+            } else {
+                m_baudFallbackPinged = true;
+                ping();
+                m_baudTimer->start(BAUD_VERIFY_TIMEOUT_MS);
+            }
+            break;
+
+        case BaudState::Idle:
+            break;
+    }
+}
+
+bool SerialManager::switchTransportBaud(int baudRate)
+{
+    // The pacer's per-byte cost follows the rate, or a faster link would
+    // still be held to the base rate's throughput
+    bool ok = false;
+    const PacingProfile pacing = pacingProfile(m_boardType, baudRate);
+    QMetaObject::invokeMethod(m_transport, [&]() {
+        ok = m_transport->setBaudRate(baudRate, pacing);
+    }, Qt::BlockingQueuedConnection);
+
+    if (ok) {
+        m_baudRate = baudRate;
+    }
+    return ok;
+}
+
+// =============================================================================
+// Receive Handling
+// =============================================================================
+
+void SerialManager::onDataReceived(const QByteArray& data, qint64 timestampUs)
+{
+    m_rxTimestampUs = timestampUs;
+    m_rxEvents.clear();
+    m_rxParser.parse(data.constData(), data.size(), m_rxEvents,
+                     [this](const QByteArray& sysex) { processSysEx(sysex); });
+
+    // Raw bytes for activity monitoring, parsed messages as one batch
+    emit midiDataReceived(data);
+    if (!m_rxEvents.empty()) {
+        emit midiEventsReceived(m_rxEvents);
     }
 }
 
@@ -381,12 +1340,45 @@ void SerialManager::processSysEx(const QByteArray& sysex)
             break;
 
         case SysEx::RESP_IDENTITY:
-            // F0 7D 00 81 <mode> <version> F7
+            // F0 7D 00 81 <mode> <version> [<baud mask>] F7
             if (sysex.size() >= 5 + 2) {
                 uint8_t mode = static_cast<uint8_t>(sysex[4]);
                 uint8_t version = static_cast<uint8_t>(sysex[5]);
+                uint8_t baudMask = (sysex.size() >= 5 + 3) ? static_cast<uint8_t>(sysex[6]) : 0;
                 emit identityReceived(mode, version);
-                qDebug() << "Device identified: mode=" << mode << "version=" << version;
+                if (!m_calibration.active && !m_health.awaiting) {
+                    qDebug() << "Device identified: mode=" << mode << "version=" << version;
+                }
+                handleIdentityBaud(baudMask);
+                if (m_calibration.awaiting) {
+                    handleCalibrationReply();
+                } else if (m_health.awaiting) {
+                    handleHealthReply();
+                }
+            }
+            break;
+
+        case SysEx::RESP_BAUD_ACK:
+            // F0 7D 00 83 <code> F7
+            if (sysex.size() >= 5 + 1) {
+                handleBaudAck(static_cast<uint8_t>(sysex[4]));
+            }
+            break;
+
+        case SysEx::RESP_BULK_ACK:
+            // F0 7D 00 82 <seq> <status> <checksum> F7
+            if (sysex.size() >= 5 + 3) {
+                handleBulkAck(static_cast<uint8_t>(sysex[4]),
+                              static_cast<uint8_t>(sysex[5]),
+                              static_cast<uint8_t>(sysex[6]));
+            }
+            break;
+
+        case SysEx::RESP_TELEMETRY:
+            // F0 7D 00 84 <loop avg:3> <loop max:3> <rx overflows:2>
+            //             <sysex dropped:2> <fm voices> <psg voices> F7
+            if (sysex.size() >= 5 + TELEMETRY_PAYLOAD) {
+                handleTelemetry(reinterpret_cast<const uint8_t*>(sysex.constData() + 4));
             }
             break;
 
@@ -396,13 +1388,13 @@ void SerialManager::processSysEx(const QByteArray& sysex)
     }
 }
 
-void SerialManager::onError(QSerialPort::SerialPortError error)
+void SerialManager::onError(QSerialPort::SerialPortError error, const QString& message)
 {
     if (error == QSerialPort::NoError) {
         return;
     }
 
-    qDebug() << "Serial error:" << m_port->errorString();
+    qDebug() << "Serial error:" << message;
 
     if (error == QSerialPort::ResourceError) {
         // Device disconnected
@@ -411,7 +1403,7 @@ void SerialManager::onError(QSerialPort::SerialPortError error)
 
     m_state = ConnectionState::Error;
     emit connectionStateChanged(m_state);
-    emit connectionError(m_port->errorString());
+    emit connectionError(message);
 }
 
 void SerialManager::onAutoDetectTimer()
@@ -456,6 +1448,28 @@ bool SerialManager::isArduinoPort(const QSerialPortInfo& info) const
            desc.contains("ch340") || desc.contains("ftdi");
 }
 
+PacingProfile SerialManager::pacingProfile(BoardType type, int baudRate)
+{
+    PacingProfile profile;
+    switch (type) {
+        case BoardType::Teensy:
+            // USB CDC is flow-controlled end to end - no pacing needed
+            break;
+        case BoardType::Arduino:
+        case BoardType::Unknown:
+            // Unknown boards may be an AVR behind a generic USB-serial chip,
+            // so err on the side of not overflowing them
+            // 10 bits per byte on the wire, rounded up to whole microseconds
+            profile.rxBufferBytes = AVR_RX_BUFFER_BYTES;
+            profile.byteCostUs = static_cast<int>(
+                (qint64(10) * 1000000 * AVR_BYTE_COST_PERCENT + qint64(baudRate) * 100 - 1) /
+                (qint64(baudRate) * 100));
+            profile.sysexCostUs = AVR_SYSEX_COST_US;
+            break;
+    }
+    return profile;
+}
+
 BoardType SerialManager::detectBoardType(const QString& portName) const
 {
     const auto ports = QSerialPortInfo::availablePorts();
@@ -5,13 +5,96 @@
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QTimer>
+#include <QThread>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QMap>
 #include <vector>
 #include "Types.h"
+#include "SerialTransport.h"
+#include "OutputScheduler.h"
+#include "MidiParser.h"
+#include "RttHistogram.h"
+
+class MIDIManager;
+
+/**
+ * Result of a ping-burst latency calibration for one connection. Round
+ * trips run from the ping's write() to the read that completes its
+ * RESP_IDENTITY, both stamped on the transport thread. The one-way latency
+ * is half the median round trip.
+ */
+struct LatencyCalibration {
+    bool valid = false;
+    QString port;
+    BoardType boardType = BoardType::Unknown;
+    int baudRate = 0;
+    int samples = 0;
+    int lost = 0;
+    double rttMinUs = 0.0;
+    double rttMedianUs = 0.0;
+    double rttMeanUs = 0.0;
+    double rttMaxUs = 0.0;
+    double oneWayUs = 0.0;
+    double jitterUs = 0.0;      // Standard deviation of the one-way estimate
+
+    // key=value lines for export, including the DAW track delay to use
+    QString toText() const;
+};
+
+/**
+ * Rolling view of the link from the background health pings. Round trips
+ * cover the last RttHistogram::WINDOW answered pings; counters run since
+ * connecting.
+ */
+struct LinkHealth {
+    bool monitoring = false;
+    int samples = 0;
+    quint64 pingsSent = 0;
+    quint64 pingsLost = 0;
+    qint64 lastRttUs = 0;
+    qint64 rttP50Us = 0;
+    qint64 rttP95Us = 0;
+    qint64 rttP99Us = 0;
+    qint64 rttMaxUs = 0;
+    qint64 baselineUs = 0;      // Lowest p50 seen on this connection
+    int txQueueDepth = 0;       // Messages waiting in the TX rings
+    quint64 txDropped = 0;
+    quint64 timedWritten = 0;   // Scheduled events written to the port
+    quint64 timedLate = 0;      // ... later than OutputScheduler::LATE_THRESHOLD_US
+    qint64 timedMaxLatenessUs = 0;
+    bool degraded = false;
+    QString reason;             // Why degraded, empty otherwise
+
+    QString toText() const;     // One line for the log and status display
+};
+
+/**
+ * Firmware-side counters from the last RESP_TELEMETRY. Loop times cover the
+ * interval since the previous request. Overrun totals are unwrapped from
+ * the device's 14-bit counters and count since the device booted; the
+ * *Delta fields are the increase since the previous reply.
+ */
+struct DeviceTelemetry {
+    bool valid = false;
+    int loopAvgUs = 0;
+    int loopMaxUs = 0;
+    quint64 rxOverflows = 0;        // Bytes lost to a full serial RX buffer
+    quint64 sysexDropped = 0;       // SysEx discarded (too long, truncated)
+    int rxOverflowsDelta = 0;
+    int sysexDroppedDelta = 0;
+    int fmVoices = 0;               // FM channels sounding
+    int psgVoices = 0;              // PSG channels sounding
+
+    QString toText() const;         // One line for the log and status display
+};
 
 /**
  * Manages serial communication with the GenesisEngine device.
  * Handles MIDI message transmission and SysEx commands.
+ *
+ * The port itself lives on a SerialTransport thread; the send* methods only
+ * push into its lock-free TX ring and are safe to call from any thread.
  */
 class SerialManager : public QObject
 {
@@ -28,6 +111,46 @@ public:
     bool isConnected() const;
     QString connectedPort() const;
     BoardType detectedBoardType() const { return m_boardType; }
+    int baudRate() const { return m_baudRate; }
+
+    // Latency calibration: ping the device `pings` times, one at a time, and
+    // measure the round trips. With compensation on, the result shifts
+    // scheduled output earlier by the one-way latency. Reset on disconnect.
+    bool startLatencyCalibration(int pings = CALIBRATION_PINGS);
+    bool isCalibrating() const { return m_calibration.active; }
+    LatencyCalibration latencyCalibration() const { return m_calibration.result; }
+    void setLatencyCompensation(bool enabled);
+    bool latencyCompensation() const { return m_latencyCompensation; }
+
+    // Link health: while connected, ping every intervalMs in the background
+    // and track round trips, lost pings and TX queue depth. Pings pause
+    // during calibration, baud negotiation and bank uploads.
+    void setLinkHealthMonitor(bool enabled, int intervalMs = HEALTH_PING_INTERVAL_MS);
+    bool linkHealthMonitor() const { return m_health.enabled; }
+    int linkHealthInterval() const { return m_health.intervalMs; }
+    LinkHealth linkHealth() const { return m_health.status; }
+
+    // Device telemetry: request loop time, overrun counters and voices every
+    // intervalMs while connected (0 = off). Polling stops if the firmware
+    // never answers. Reset on disconnect.
+    void setTelemetryInterval(int intervalMs);
+    int telemetryInterval() const { return m_telemetry.intervalMs; }
+    DeviceTelemetry deviceTelemetry() const { return m_telemetry.last; }
+    void requestTelemetry();
+
+    // TX write coalescing: flush after flushBytes or maxLatencyMs (0 = every loop turn)
+    void setWriteCoalescing(int flushBytes, int maxLatencyMs);
+
+    // Omit repeated status bytes on the wire (firmware must accept running status)
+    void setRunningStatusEnabled(bool enabled);
+
+    // Keep only the newest value per (channel, controller) for continuous
+    // controllers and pitch bend, flushed at up to maxRateHz as the link allows
+    void setControllerThinning(bool enabled, int maxRateHz);
+
+    // Echo device MIDI and patch dumps to midi's virtual output from the
+    // transport thread (nullptr to stop)
+    void setEchoTarget(MIDIManager* midi);
 
     // Raw MIDI message sending
     void sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity);
@@ -35,57 +158,251 @@ public:
     void sendControlChange(uint8_t channel, uint8_t cc, uint8_t value);
     void sendProgramChange(uint8_t channel, uint8_t program);
     void sendPitchBend(uint8_t channel, uint16_t value);
-    void sendRawMIDI(const std::vector<uint8_t>& data);
+    // Return false if the message could not be queued (not connected, TX ring full)
+    bool sendMidi(const MidiMessage& message);
+    bool sendRawSysEx(const SysExMessage& message);   // Complete F0 ... F7
+
+    // Timed output: send at dueUs on the OutputScheduler::nowUs() clock (the
+    // one MIDI input is stamped with) from the scheduler's dispatch thread.
+    // Thread-safe; pending events are dropped on disconnect.
+    bool scheduleMidi(const MidiMessage& message, qint64 dueUs);
+    bool scheduleSysEx(const SysExMessage& message, qint64 dueUs);
+    OutputScheduler* scheduler() const { return m_scheduler; }
+    // Used by the dispatch thread: the transport reports the lateness of the
+    // actual write against sendAtUs back to the scheduler
+    bool sendTimed(const MidiMessage& message, qint64 sendAtUs);
+    bool sendTimed(const SysExMessage& message, qint64 sendAtUs);
 
     // SysEx commands
     void sendFMPatchToChannel(uint8_t channel, const FMPatch& patch);
     void sendFMPatchToSlot(uint8_t slot, const FMPatch& patch);
+    void sendFMParameter(uint8_t channel, int opIndex, FMParam param, uint8_t value);
+
+    // Live edit: keeps only the newest state per channel and sends it when
+    // the link is idle, at most setLiveEditMaxRate() times per second
+    void queueLivePatch(uint8_t channel, const FMPatch& patch);
+    void queueLiveParameter(uint8_t channel, int opIndex, FMParam param, uint8_t value);
+    void setLiveEditMaxRate(int hz);
     void sendPSGEnvelope(uint8_t channel, const PSGEnvelope& env);
     void recallPatchToChannel(uint8_t channel, uint8_t slot);
+    // Thread-safe: recall slot to channel and send message right behind it
+    bool recallPatchThenSend(uint8_t channel, uint8_t slot, const MidiMessage& message);
     void requestPatchDump(uint8_t slot);
     void requestAllPatches();
     void setSynthMode(SynthMode mode);
     void ping();
 
+    // Note-offs for exactly the notes the device is holding (plus the CC
+    // 120/123 spray on Teensy, which also hears USB MIDI directly); returns
+    // the number of notes released
+    int panic();
+    int activeNoteCount() const { return m_transport->activeNoteCount(); }
+
+    // Stuck-note watchdog: release notes held past limitMs after their MIDI
+    // input closed (0 = off). notifyInputClosed is thread-safe.
+    void setStuckNoteLimit(int limitMs);
+    int stuckNoteLimit() const { return m_transport->stuckNoteLimit(); }
+    void notifyInputClosed(int sourceId);
+
+    // Acknowledged bank upload: stores patches[i] to slot i, keeping a
+    // window of frames in flight and retransmitting only failed ones
+    bool uploadBank(const std::vector<FMPatch>& patches);
+    void cancelBankUpload();
+    bool isBankUploadActive() const { return m_bulk.active; }
+
 signals:
     void connected();
     void disconnected();
     void connectionError(const QString& error);
     void connectionStateChanged(ConnectionState state);
     void boardTypeDetected(BoardType type);
+    void baudRateChanged(int baudRate);
 
     // Data received from device
     void patchReceived(uint8_t slot, const FMPatch& patch);
     void identityReceived(uint8_t mode, uint8_t version);
     void midiDataReceived(const QByteArray& data);
-    void ccReceived(uint8_t channel, uint8_t cc, uint8_t value);
+    void midiEventsReceived(const std::vector<MidiMessage>& events);  // One batch per read
+
+    // Bank upload
+    void bankUploadProgress(int slotsDone, int slotsTotal);
+    // slotsStored were acknowledged; slotsUnverified were sent as plain
+    // stores to firmware that can't acknowledge them
+    void bankUploadFinished(bool success, int slotsStored, int slotsUnverified, double bytesPerSecond);
+
+    // Latency calibration
+    void calibrationProgress(int pingsDone, int pingsTotal);
+    void calibrationFinished(const LatencyCalibration& result);
+
+    // Link health: after every health ping (answered or lost)
+    void linkHealthChanged(const LinkHealth& health);
+
+    // Device telemetry: every RESP_TELEMETRY
+    void telemetryReceived(const DeviceTelemetry& telemetry);
 
 private slots:
-    void onReadyRead();
-    void onError(QSerialPort::SerialPortError error);
+    void onDataReceived(const QByteArray& data, qint64 timestampUs);
+    void onError(QSerialPort::SerialPortError error, const QString& message);
     void onAutoDetectTimer();
+    void onBulkTimer();
+    void onBaudTimer();
+    void onCalibrationTimer();
+    void onHealthTimer();
+    void onTelemetryTimer();
 
 private:
+    void enqueue(const QByteArray& message);
     void sendSysEx(const std::vector<uint8_t>& data);
+    static QByteArray buildSysEx(const std::vector<uint8_t>& data);
+    static QByteArray buildFMPatchLoad(uint8_t channel, const FMPatch& patch);
+    static QByteArray buildFMParameter(uint8_t channel, int opIndex, FMParam param, uint8_t value);
     void processSysEx(const QByteArray& sysex);
     bool isArduinoPort(const QSerialPortInfo& info) const;
     BoardType detectBoardType(const QString& portName) const;
+    static PacingProfile pacingProfile(BoardType type, int baudRate);
+    void fillBulkWindow();
+    void sendBulkFrame(int slot);
+    void handleBulkAck(uint8_t seq, uint8_t status, uint8_t checksum);
+    void finishBankUpload(bool success);
+    void sendCalibrationPing();
+    void handleCalibrationReply();
+    void finishLatencyCalibration(bool aborted);
+    void applyLatencyCompensation();
+    void startLinkHealth();
+    void handleHealthReply();
+    void updateLinkHealth();
+    void handleTelemetry(const uint8_t* data);
+    void handleIdentityBaud(uint8_t baudMask);
+    void handleBaudAck(uint8_t code);
+    void tryNextBaudRate();
+    bool switchTransportBaud(int baudRate);
 
-    QSerialPort* m_port;
+    QThread* m_transportThread;
+    SerialTransport* m_transport;
+    OutputScheduler* m_scheduler;
+    QString m_portName;
     QTimer* m_autoDetectTimer;
-    QByteArray m_rxBuffer;
-    bool m_inSysEx;
+    MidiParser m_rxParser;
+    std::vector<MidiMessage> m_rxEvents;   // Reused for every read
     ConnectionState m_state;
     BoardType m_boardType = BoardType::Unknown;
 
-    // MIDI message parsing state
-    uint8_t m_midiStatus = 0;      // Running status
-    uint8_t m_midiData1 = 0;       // First data byte
-    int m_midiExpectedBytes = 0;   // How many more data bytes expected
-    int m_midiDataCount = 0;       // Data bytes received so far
+    // Bank upload state
+    struct BulkFrame {
+        QByteArray payload;       // <slot> <42 patch bytes>
+        uint8_t checksum = 0;
+        qint64 sentAtMs = 0;
+        int attempts = 0;
+        bool acked = false;
+    };
+    struct BulkUpload {
+        bool active = false;
+        std::vector<BulkFrame> frames;     // Indexed by slot
+        QMap<uint8_t, int> inFlight;       // seq -> slot
+        int nextSlot = 0;                  // Next slot not yet sent
+        int ackedCount = 0;
+        int unverifiedCount = 0;           // Sent by the unacknowledged fallback
+        int window = 1;
+        uint8_t nextSeq = 0;
+        bool anyAck = false;               // Device understands bulk frames
+        qint64 bytesSent = 0;
+        QElapsedTimer clock;
+    };
+    BulkUpload m_bulk;
+    QTimer* m_bulkTimer;
+
+    // Baud negotiation: open at BAUD_RATE, then step down through the
+    // rates both ends support until one survives a ping
+    enum class BaudState {
+        Idle,
+        AwaitingAck,   // CMD_SET_BAUD sent at the current rate
+        Verifying,     // Switched, pinging at the new rate
+        Reverting      // Failed, waiting for the device to fall back
+    };
+    BaudState m_baudState = BaudState::Idle;
+    QList<QPair<uint8_t, int>> m_baudCandidates;   // (mask bit, rate), fastest first
+    bool m_baudNegotiated = false;
+    bool m_baudFallbackPinged = false;
+    int m_baudRate = BAUD_RATE;
+    QTimer* m_baudTimer;
 
+    // Latency calibration: one ping in flight at a time
+    struct Calibration {
+        bool active = false;
+        bool awaiting = false;          // Ping sent, reply not yet seen
+        int total = 0;
+        int sent = 0;
+        int lost = 0;
+        qint64 requestedUs = 0;         // Transport clock when the ping was queued
+        std::vector<qint64> rttUs;
+        LatencyCalibration result;
+    };
+    Calibration m_calibration;
+    QTimer* m_calibrationTimer;
+    bool m_latencyCompensation = true;
+    qint64 m_rxTimestampUs = 0;         // Transport clock of the read being parsed
+
+    // Link health: one background ping in flight at a time
+    struct HealthMonitor {
+        bool enabled = false;
+        int intervalMs = HEALTH_PING_INTERVAL_MS;
+        bool awaiting = false;
+        bool replyOverdue = false;      // A ping timed out; its reply may still arrive
+        qint64 requestedUs = 0;
+        int consecutiveLost = 0;
+        int consecutiveSlow = 0;
+        quint64 droppedAtStart = 0;
+        quint64 droppedLastTick = 0;
+        RttHistogram rtts;
+        LinkHealth status;
+    };
+    HealthMonitor m_health;
+    QTimer* m_healthTimer;
+
+    // Device telemetry polling
+    struct TelemetryPoll {
+        int intervalMs = 0;
+        int unanswered = 0;             // Requests since the last reply
+        bool supported = false;         // Device has answered at least once
+        uint16_t rxOverflowsRaw = 0;    // Last 14-bit counter values
+        uint16_t sysexDroppedRaw = 0;
+        DeviceTelemetry last;
+    };
+    TelemetryPoll m_telemetry;
+    QTimer* m_telemetryTimer;
+
+    static constexpr int RX_EVENT_RESERVE = 256;
     static constexpr int BAUD_RATE = 115200;
     static constexpr int AUTO_DETECT_INTERVAL_MS = 2000;
+    static constexpr int BAUD_ACK_TIMEOUT_MS = 300;
+    static constexpr int BAUD_VERIFY_TIMEOUT_MS = 300;
+    static constexpr int BAUD_DEVICE_REVERT_MS = 600;   // Firmware reverts after 500 ms silence
+    static constexpr int BULK_WINDOW_TEENSY = 8;
+    static constexpr int BULK_WINDOW_AVR = 2;     // Pacer already bounds the RX buffer
+    static constexpr int BULK_ACK_TIMEOUT_MS = 250;
+    static constexpr int BULK_MAX_ATTEMPTS = 4;
+    static constexpr int CALIBRATION_PINGS = 32;
+    static constexpr int CALIBRATION_TIMEOUT_MS = 250;
+    static constexpr int CALIBRATION_SPACING_MS = 20;   // Let each reply fully drain
+    static constexpr int HEALTH_PING_INTERVAL_MS = 1000; // Also the reply timeout
+    static constexpr int HEALTH_MIN_INTERVAL_MS = 250;
+    static constexpr int HEALTH_MIN_SAMPLES = 8;         // Before a baseline is trusted
+    static constexpr int HEALTH_LOST_LIMIT = 2;          // Consecutive unanswered pings
+    static constexpr int HEALTH_SLOW_LIMIT = 2;          // Consecutive slow round trips
+    static constexpr int HEALTH_SLOW_FACTOR = 4;         // Slow = this times the baseline...
+    static constexpr qint64 HEALTH_SLOW_FLOOR_US = 5000; // ...and at least this
+    static constexpr int HEALTH_QUEUE_LIMIT = 256;       // A quarter of a MIDI ring
+    static constexpr int TELEMETRY_MIN_INTERVAL_MS = 100;
+    static constexpr int TELEMETRY_GIVE_UP = 3;          // Unanswered before assuming old firmware
+    static constexpr int TELEMETRY_PAYLOAD = 12;         // Data bytes in RESP_TELEMETRY
+
+    // AVR pacing: 64-byte hardware RX ring, firmware parse cost per byte as a
+    // percentage of the byte's wire time (firmware that offers a faster rate
+    // must keep up with it), and time to write a full patch to the YM2612
+    // once its SysEx is complete
+    static constexpr int AVR_RX_BUFFER_BYTES = 64;
+    static constexpr int AVR_BYTE_COST_PERCENT = 115;   // ~100 us at 115200
+    static constexpr int AVR_SYSEX_COST_US = 2000;
 };
 
 #endif // SERIALMANAGER_H
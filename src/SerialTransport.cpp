@@ -0,0 +1,854 @@
+#include "SerialTransport.h"
+#include "MIDIManager.h"
+#include "OutputScheduler.h"
+#include "Types.h"
+#include <QDebug>
+
+SerialTransport::SerialTransport(QObject* parent)
+    : QObject(parent)
+    , m_port(new QSerialPort(this))
+    , m_flushTimer(new QTimer(this))
+    , m_liveTimer(new QTimer(this))
+    , m_bulkTimer(new QTimer(this))
+    , m_paceTimer(new QTimer(this))
+    , m_thinTimer(new QTimer(this))
+    , m_watchdogTimer(new QTimer(this))
+{
+    m_txBuffer.reserve(TX_BUFFER_RESERVE);
+    m_txMarks.reserve(TX_MARK_RESERVE);
+    m_echoEvents.reserve(ECHO_EVENT_RESERVE);
+    m_clock.start();
+
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_flushTimer, &QTimer::timeout,
+                     this, &SerialTransport::flushTx);
+    m_liveTimer->setSingleShot(true);
+    m_liveTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_liveTimer, &QTimer::timeout,
+                     this, &SerialTransport::serviceLiveEdits);
+    m_bulkTimer->setSingleShot(true);
+    m_bulkTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_bulkTimer, &QTimer::timeout,
+                     this, &SerialTransport::serviceBulk);
+    m_paceTimer->setSingleShot(true);
+    m_paceTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_paceTimer, &QTimer::timeout,
+                     this, &SerialTransport::onPaceTimer);
+    m_thinTimer->setSingleShot(true);
+    m_thinTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_thinTimer, &QTimer::timeout,
+                     this, &SerialTransport::serviceThinned);
+    m_watchdogTimer->setInterval(WATCHDOG_INTERVAL_MS);
+    QObject::connect(m_watchdogTimer, &QTimer::timeout,
+                     this, &SerialTransport::checkStuckNotes);
+    QObject::connect(m_port, &QSerialPort::bytesWritten,
+                     this, &SerialTransport::serviceLiveEdits);
+    QObject::connect(m_port, &QSerialPort::readyRead,
+                     this, &SerialTransport::onReadyRead);
+    QObject::connect(m_port, &QSerialPort::errorOccurred,
+                     this, &SerialTransport::onError);
+}
+
+SerialTransport::~SerialTransport()
+{
+    close();
+}
+
+SerialTransport::Priority SerialTransport::classify(uint8_t status)
+{
+    if (status >= 0xF8) return Priority::Realtime;
+    if (status == 0xF0 || status == 0xF7) return Priority::Bulk;
+
+    // Notes and controllers must stay in order: a program change or pedal
+    // sent before a note has to reach the device before it
+    return Priority::Channel;
+}
+
+bool SerialTransport::isThinnable(const MidiMessage& message)
+{
+    switch (message.type()) {
+        case 0xD0:
+        case 0xE0:
+            return true;
+        case 0xB0: {
+            // Only continuous controllers: bank select, data entry, RPN/NRPN
+            // and channel mode messages depend on order, and switch pedals
+            // must not lose an off/on pair
+            uint8_t cc = message.data1();
+            return cc != 0 && cc != 6 && cc != 32 && cc != 38 &&
+                   !(cc >= 64 && cc <= 69) && !(cc >= 96 && cc <= 101) && cc < 120;
+        }
+        default:
+            return false;
+    }
+}
+
+bool SerialTransport::enqueue(const MidiMessage& message, qint64 sendAtUs)
+{
+    if (message.isEmpty()) {
+        return false;
+    }
+
+    if (sendAtUs < 0 && m_thinEnabled.load(std::memory_order_relaxed) && isThinnable(message)) {
+        return enqueueThinned(message);
+    }
+
+    QueuedMessage entry;
+    entry.message = message;
+    entry.sendAtUs = sendAtUs;
+    return push(classify(message.status()) == Priority::Realtime ? m_realtimeRing : m_channelRing,
+                entry);
+}
+
+bool SerialTransport::enqueueAfterRecall(uint8_t channel, uint8_t slot, const MidiMessage& message)
+{
+    if (message.isEmpty() || channel > 0x0F || slot > 0x7F) {
+        return false;
+    }
+
+    QueuedMessage entry;
+    entry.message = message;
+    entry.recallChannel = static_cast<int8_t>(channel);
+    entry.recallSlot = slot;
+    return push(m_channelRing, entry);
+}
+
+bool SerialTransport::push(MessageRing& ring, const QueuedMessage& entry)
+{
+    if (!ring.push(entry)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    scheduleDrain();
+    return true;
+}
+
+bool SerialTransport::enqueueThinned(const MidiMessage& message)
+{
+    const int channel = message.channel();
+    const int controller = message.type() == 0xB0 ? message.data1()
+                         : message.type() == 0xD0 ? 128 : 129;
+    const int index = channel * THIN_SLOTS_PER_CHANNEL + controller;
+    const uint32_t packed = THIN_PENDING | (uint32_t(message.data1()) << 8) | message.data2();
+
+    uint32_t previous = m_thinSlots[index].exchange(packed, std::memory_order_acq_rel);
+    if (previous & THIN_PENDING) {
+        // Replaced a value that never reached the wire
+        m_thinned.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (!m_thinDirty.push(static_cast<uint16_t>(index))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    scheduleDrain();
+    return true;
+}
+
+bool SerialTransport::enqueue(const SysExMessage& message, qint64 sendAtUs)
+{
+    if (message.isEmpty()) {
+        return false;
+    }
+
+    if (!m_bulkRing.push(QueuedSysEx{message, sendAtUs})) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    scheduleDrain();
+    return true;
+}
+
+bool SerialTransport::enqueue(const QByteArray& message)
+{
+    const auto* data = reinterpret_cast<const uint8_t*>(message.constData());
+    const size_t size = static_cast<size_t>(message.size());
+    if (size == 0) {
+        return false;
+    }
+
+    if (data[0] == 0xF0) {
+        return enqueue(SysExMessage::fromBytes(data, size));
+    }
+
+    // Split a run of complete short messages
+    bool ok = true;
+    size_t i = 0;
+    while (i < size) {
+        MidiMessage shortMessage = MidiMessage::fromBytes(data + i, size - i);
+        if (shortMessage.isEmpty()) {
+            break;
+        }
+        ok = enqueue(shortMessage) && ok;
+        i += shortMessage.length;
+    }
+    return ok;
+}
+
+void SerialTransport::scheduleDrain()
+{
+    // Only the first producer since the last drain posts a wake-up, so a
+    // burst of messages costs one queued event rather than one per message
+    if (!m_drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &SerialTransport::drain, Qt::QueuedConnection);
+    }
+}
+
+void SerialTransport::enqueueLatest(int channel, int key, QByteArray message)
+{
+    if (channel < 0 || channel >= static_cast<int>(m_liveEdits.size())) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_liveMutex);
+        LiveEditSlot& slot = m_liveEdits[channel];
+        if (key == LIVE_KEY_PATCH) {
+            // A full patch reflects every newer parameter edit too
+            slot.patch = std::move(message);
+            slot.params.clear();
+        } else {
+            slot.params.insert(key, std::move(message));
+        }
+        m_liveEditPending.store(true, std::memory_order_release);
+    }
+
+    scheduleDrain();
+}
+
+void SerialTransport::setLiveEditMaxRate(int hz)
+{
+    m_liveMinIntervalUs.store(hz > 0 ? 1000000 / hz : 0, std::memory_order_relaxed);
+}
+
+void SerialTransport::setControllerThinning(bool enabled, int maxRateHz)
+{
+    m_thinMinIntervalUs.store(maxRateHz > 0 ? 1000000 / maxRateHz : 0, std::memory_order_relaxed);
+    m_thinEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void SerialTransport::setStuckNoteLimit(int limitMs)
+{
+    m_stuckNoteLimitMs.store(qMax(0, limitMs), std::memory_order_relaxed);
+}
+
+void SerialTransport::notifySourceClosed(int sourceId)
+{
+    if (sourceId >= 0 && sourceId < MAX_WATCHED_SOURCES) {
+        m_sourceClosedUs[sourceId].store(nowUs(), std::memory_order_relaxed);
+    }
+}
+
+void SerialTransport::setCoalescing(int flushBytes, int maxLatencyMs)
+{
+    m_flushBytes.store(qMax(1, flushBytes), std::memory_order_relaxed);
+    m_maxLatencyMs.store(qMax(0, maxLatencyMs), std::memory_order_relaxed);
+}
+
+bool SerialTransport::open(const QString& portName, int baudRate, const PacingProfile& pacing)
+{
+    close();
+
+    m_port->setPortName(portName);
+    m_port->setBaudRate(baudRate);
+    m_port->setDataBits(QSerialPort::Data8);
+    m_port->setParity(QSerialPort::NoParity);
+    m_port->setStopBits(QSerialPort::OneStop);
+    m_port->setFlowControl(QSerialPort::NoFlowControl);
+
+    if (!m_port->open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    // Discard anything queued while the port was closed
+    QueuedMessage staleMessage;
+    while (m_realtimeRing.pop(staleMessage)) {}
+    while (m_channelRing.pop(staleMessage)) {}
+    QueuedSysEx staleSysEx;
+    while (m_bulkRing.pop(staleSysEx)) {}
+    m_txBuffer.resize(0);
+    m_txMarks.clear();
+    resetRunningStatus();
+    {
+        QMutexLocker locker(&m_liveMutex);
+        for (LiveEditSlot& slot : m_liveEdits) {
+            slot = LiveEditSlot();
+        }
+        m_liveEditPending.store(false, std::memory_order_release);
+    }
+    uint16_t staleIndex;
+    while (m_thinDirty.pop(staleIndex)) {
+        m_thinSlots[staleIndex].store(0, std::memory_order_relaxed);
+    }
+    m_thinIntervalUs = m_thinMinIntervalUs.load(std::memory_order_relaxed);
+    m_lastThinSendUs = 0;
+    m_activeNotes.reset();
+    m_wireIdleAtUs = 0;
+    m_bulkIdleAtUs = 0;
+    m_pacing = pacing;
+    m_paceBacklogUs = 0;
+    m_paceUpdatedUs = nowUs();
+    m_echoParser.reset();
+    m_watchdogTimer->start();
+
+    m_open.store(true, std::memory_order_release);
+    return true;
+}
+
+void SerialTransport::close()
+{
+    m_open.store(false, std::memory_order_release);
+    m_flushTimer->stop();
+    m_liveTimer->stop();
+    m_bulkTimer->stop();
+    m_paceTimer->stop();
+    m_thinTimer->stop();
+    m_watchdogTimer->stop();
+
+    if (m_port->isOpen()) {
+        // Don't let pacing strand the tail of the buffer
+        m_pacing = PacingProfile();
+        flushTx();
+        m_port->close();
+    }
+    m_txBuffer.resize(0);
+    m_txMarks.clear();
+}
+
+bool SerialTransport::setBaudRate(int baudRate, const PacingProfile& pacing)
+{
+    if (!m_port->isOpen()) {
+        return false;
+    }
+
+    // Bytes already handed to the driver must leave at the old rate
+    flushTx();
+    m_port->flush();
+    m_port->waitForBytesWritten(100);
+    resetRunningStatus();
+    if (!m_port->setBaudRate(baudRate)) {
+        return false;
+    }
+
+    // Work already in the device's buffer is kept; only new bytes cost less
+    m_pacing = pacing;
+    return true;
+}
+
+void SerialTransport::drain()
+{
+    // Clear the flag before popping so a push racing with this drain
+    // schedules another one instead of being stranded in a ring
+    m_drainScheduled.store(false, std::memory_order_release);
+
+    const int flushBytes = m_flushBytes.load(std::memory_order_relaxed);
+
+    // Highest priority first
+    drainRing(m_realtimeRing, flushBytes);
+    drainRing(m_channelRing, flushBytes);
+
+    if (!m_txBuffer.isEmpty()) {
+        const int maxLatencyMs = m_maxLatencyMs.load(std::memory_order_relaxed);
+        if (maxLatencyMs == 0) {
+            flushTx();
+        } else if (!m_flushTimer->isActive()) {
+            m_flushTimer->start(maxLatencyMs);
+        }
+    }
+
+    serviceThinned();
+    serviceBulk();
+    serviceLiveEdits();
+}
+
+void SerialTransport::drainRing(MessageRing& ring, int flushBytes)
+{
+    const qint64 now = nowUs();
+    QueuedMessage entry;
+    while (ring.pop(entry)) {
+        if (entry.recallChannel >= 0) {
+            const char recall[7] = {
+                static_cast<char>(0xF0), static_cast<char>(SysEx::MANUFACTURER_ID),
+                static_cast<char>(SysEx::DEVICE_ID), static_cast<char>(SysEx::CMD_RECALL_PATCH),
+                static_cast<char>(entry.recallChannel), static_cast<char>(entry.recallSlot),
+                static_cast<char>(0xF7)
+            };
+            appendMessage(recall, sizeof(recall));
+        }
+        const MidiMessage& message = entry.message;
+        // Controller values queued before this note (a bend reset, the mod
+        // wheel) must reach the channel ahead of it
+        if (message.type() == 0x80 || message.type() == 0x90) {
+            flushThinnedChannel(message.channel());
+        }
+        m_activeNotes.track(message, now);
+        appendMessage(message.constData(), message.length);
+        if (entry.sendAtUs >= 0) {
+            markTx(entry.sendAtUs);
+        }
+        if (m_txBuffer.size() >= flushBytes) {
+            flushTx();
+        }
+    }
+}
+
+void SerialTransport::serviceBulk()
+{
+    if (!m_port->isOpen() || m_bulkRing.sizeApprox() == 0) {
+        return;
+    }
+
+    // A paced remainder is still waiting for room in the device buffer
+    if (m_paceTimer->isActive()) {
+        return;
+    }
+
+    // Only one SysEx frame may be in flight; anything of higher priority
+    // that arrives meanwhile is written straight behind it
+    qint64 now = nowUs();
+    if (m_bulkIdleAtUs > now) {
+        if (!m_bulkTimer->isActive()) {
+            m_bulkTimer->start(static_cast<int>((m_bulkIdleAtUs - now + 999) / 1000));
+        }
+        return;
+    }
+
+    QueuedSysEx entry;
+    if (!m_bulkRing.pop(entry)) {
+        return;
+    }
+    const SysExMessage& frame = entry.frame;
+
+    // Coalesced notes/controllers go out ahead of the frame
+    appendMessage(reinterpret_cast<const char*>(frame.data()), static_cast<int>(frame.size()));
+    if (entry.sendAtUs >= 0) {
+        markTx(entry.sendAtUs);
+    }
+
+    // Latency calibration times pings from the moment their final 0xF7 is
+    // written, which pacing may hold back past this flush
+    if (frame.size() == 5 && frame.data()[1] == SysEx::MANUFACTURER_ID &&
+        frame.data()[3] == SysEx::CMD_PING) {
+        markTx(0, true);
+    }
+    flushTx();
+    m_bulkIdleAtUs = m_wireIdleAtUs;
+
+    if (m_bulkRing.sizeApprox() > 0 && !m_bulkTimer->isActive()) {
+        m_bulkTimer->start(static_cast<int>((m_bulkIdleAtUs - now + 999) / 1000));
+    }
+}
+
+void SerialTransport::flushTx()
+{
+    m_flushTimer->stop();
+
+    if (m_txBuffer.isEmpty()) {
+        return;
+    }
+
+    if (!m_port->isOpen()) {
+        m_txBuffer.resize(0);
+        m_txMarks.clear();
+        return;
+    }
+
+    qint64 now = nowUs();
+    int count = m_pacing.enabled() ? pacedByteCount(now) : m_txBuffer.size();
+
+    if (count > 0) {
+        m_port->write(m_txBuffer.constData(), count);
+        completeMarks(count);
+
+        // 10 bits per byte on the wire (start + 8 data + stop)
+        qint64 wireUs = static_cast<qint64>(count) * 10 * 1000000 / m_port->baudRate();
+        m_wireIdleAtUs = qMax(m_wireIdleAtUs, now) + wireUs;
+    }
+
+    if (count == m_txBuffer.size()) {
+        // resize() keeps the capacity, so steady-state traffic doesn't reallocate
+        m_txBuffer.resize(0);
+        return;
+    }
+
+    // Device buffer is full - hold the rest until the firmware catches up
+    m_txBuffer.remove(0, count);
+    uint8_t next = static_cast<uint8_t>(m_txBuffer[0]);
+    qint64 cost = m_pacing.byteCostUs + (next == 0xF7 ? m_pacing.sysexCostUs : 0);
+    qint64 capacityUs = static_cast<qint64>(m_pacing.rxBufferBytes) * m_pacing.byteCostUs;
+    qint64 waitUs = qMax<qint64>(m_paceBacklogUs + cost - capacityUs, m_pacing.byteCostUs);
+    m_paceTimer->start(static_cast<int>((waitUs + 999) / 1000));
+}
+
+int SerialTransport::pacedByteCount(qint64 now)
+{
+    // The firmware works off its backlog in real time
+    m_paceBacklogUs = qMax<qint64>(0, m_paceBacklogUs - (now - m_paceUpdatedUs));
+    m_paceUpdatedUs = now;
+
+    // Bucket capacity: a full RX buffer's worth of work. Charging the SysEx
+    // cost as occupancy is conservative - the buffer keeps filling while the
+    // firmware is busy applying a patch.
+    const qint64 capacityUs = static_cast<qint64>(m_pacing.rxBufferBytes) * m_pacing.byteCostUs;
+
+    int count = 0;
+    for (char c : m_txBuffer) {
+        qint64 cost = m_pacing.byteCostUs;
+        if (static_cast<uint8_t>(c) == 0xF7) {
+            cost += m_pacing.sysexCostUs;
+        }
+        if (m_paceBacklogUs + cost > capacityUs && m_paceBacklogUs > 0) {
+            break;
+        }
+        m_paceBacklogUs += cost;
+        count++;
+    }
+    return count;
+}
+
+void SerialTransport::markTx(qint64 sendAtUs, bool ping)
+{
+    m_txMarks.push_back(TxMark{static_cast<int>(m_txBuffer.size()), sendAtUs, ping});
+}
+
+void SerialTransport::completeMarks(int written)
+{
+    // Marks within the written bytes are done; the rest move up with the
+    // buffer's remainder
+    int kept = 0;
+    for (const TxMark& mark : m_txMarks) {
+        if (mark.end > written) {
+            m_txMarks[kept++] = TxMark{mark.end - written, mark.sendAtUs, mark.ping};
+        } else if (mark.ping) {
+            m_pingWrittenUs.store(nowUs(), std::memory_order_release);
+        } else if (m_scheduler) {
+            m_scheduler->recordWrite(mark.sendAtUs);
+        }
+    }
+    m_txMarks.resize(kept);
+}
+
+void SerialTransport::onPaceTimer()
+{
+    flushTx();
+    serviceThinned();
+    serviceBulk();
+    serviceLiveEdits();
+}
+
+qint64 SerialTransport::txBacklogUs(qint64 now) const
+{
+    // Bytes the UART has yet to send, plus anything still buffered here
+    qint64 backlogUs = qMax<qint64>(0, m_wireIdleAtUs - now) +
+                       static_cast<qint64>(m_txBuffer.size()) * 10 * 1000000 / m_port->baudRate();
+
+    // On a paced board the firmware, not the wire, is the bottleneck
+    if (m_pacing.enabled()) {
+        backlogUs = qMax(backlogUs, m_paceBacklogUs - (now - m_paceUpdatedUs));
+    }
+    return backlogUs;
+}
+
+void SerialTransport::serviceThinned()
+{
+    if (!m_port->isOpen() || m_thinDirty.sizeApprox() == 0) {
+        return;
+    }
+
+    // A paced remainder is still waiting; onPaceTimer comes back here
+    if (m_paceTimer->isActive()) {
+        return;
+    }
+
+    qint64 now = nowUs();
+    qint64 readyAt = m_lastThinSendUs + m_thinIntervalUs;
+    if (readyAt > now) {
+        if (!m_thinTimer->isActive()) {
+            m_thinTimer->start(static_cast<int>((readyAt - now + 999) / 1000));
+        }
+        return;
+    }
+
+    // Adapt the flush rate to the TX backlog: back off while notes and SysEx
+    // are queued ahead, recover gradually once the link drains. Pending slots
+    // keep absorbing new values in the meantime.
+    const qint64 minIntervalUs = m_thinMinIntervalUs.load(std::memory_order_relaxed);
+    qint64 backlogUs = txBacklogUs(now);
+    m_lastThinSendUs = now;
+    if (backlogUs >= THIN_TARGET_BACKLOG_US) {
+        m_thinIntervalUs = qBound(minIntervalUs, qMax<qint64>(m_thinIntervalUs, 1000) * 2,
+                                  qMax(minIntervalUs, THIN_MAX_INTERVAL_US));
+        m_thinTimer->start(static_cast<int>((m_thinIntervalUs + 999) / 1000));
+        return;
+    }
+    m_thinIntervalUs = qMax(minIntervalUs, m_thinIntervalUs * 3 / 4);
+
+    // Send as many slots as fit under the target backlog; the rest stay
+    // queued, in order, for the next flush
+    qint64 budgetBytes = (THIN_TARGET_BACKLOG_US - backlogUs) * m_port->baudRate() / (10 * 1000000);
+    budgetBytes = qMax<qint64>(budgetBytes, 3);
+    uint16_t index;
+    while (budgetBytes > 0 && m_thinDirty.pop(index)) {
+        budgetBytes -= appendThinSlot(index);
+    }
+    flushTx();
+
+    if (m_thinDirty.sizeApprox() > 0 && !m_thinTimer->isActive()) {
+        m_thinTimer->start(static_cast<int>((m_thinIntervalUs + 999) / 1000));
+    }
+}
+
+int SerialTransport::appendThinSlot(int index)
+{
+    // Clearing the pending bit lets the next value re-queue the slot; an
+    // index still in m_thinDirty after this is skipped when it comes up
+    uint32_t packed = m_thinSlots[index].exchange(0, std::memory_order_acq_rel);
+    if (!(packed & THIN_PENDING)) {
+        return 0;
+    }
+    int channel = index / THIN_SLOTS_PER_CHANNEL;
+    int controller = index % THIN_SLOTS_PER_CHANNEL;
+    uint8_t status = static_cast<uint8_t>(
+        (controller < 128 ? 0xB0 : controller == 128 ? 0xD0 : 0xE0) | channel);
+    MidiMessage message = MidiMessage::make(status, static_cast<uint8_t>((packed >> 8) & 0x7F),
+                                            static_cast<uint8_t>(packed & 0x7F));
+    appendMessage(message.constData(), message.length);
+    return message.length;
+}
+
+void SerialTransport::flushThinnedChannel(int channel)
+{
+    if (m_thinDirty.sizeApprox() == 0) {
+        return;
+    }
+    const int first = channel * THIN_SLOTS_PER_CHANNEL;
+    for (int index = first; index < first + THIN_SLOTS_PER_CHANNEL; index++) {
+        appendThinSlot(index);
+    }
+}
+
+template <typename Match>
+int SerialTransport::releaseNotes(Match match)
+{
+    int released = m_activeNotes.release(match, [this](int channel, int note) {
+        MidiMessage noteOff = MidiMessage::make(static_cast<uint8_t>(0x80 | channel),
+                                                static_cast<uint8_t>(note), 0);
+        appendMessage(noteOff.constData(), noteOff.length);
+    });
+    if (released > 0) {
+        flushTx();
+    }
+    return released;
+}
+
+int SerialTransport::releaseActiveNotes()
+{
+    if (!m_port->isOpen()) {
+        return 0;
+    }
+
+    // Queued note-ons (with any patch recall carried ahead of them) would
+    // only start notes that are about to be stopped; everything else still
+    // goes out and reaches the bitmap first
+    const qint64 now = nowUs();
+    QueuedMessage entry;
+    while (m_channelRing.pop(entry)) {
+        const MidiMessage& message = entry.message;
+        if (message.type() == 0x90 && message.data2() > 0) {
+            continue;
+        }
+        m_activeNotes.track(message, now);
+        appendMessage(message.constData(), message.length);
+        if (entry.sendAtUs >= 0) {
+            markTx(entry.sendAtUs);
+        }
+    }
+    drain();
+    return releaseNotes([](int, int) { return true; });
+}
+
+void SerialTransport::checkStuckNotes()
+{
+    const int limitMs = m_stuckNoteLimitMs.load(std::memory_order_relaxed);
+    if (limitMs <= 0 || !m_port->isOpen() || m_activeNotes.count() == 0) {
+        return;
+    }
+
+    const qint64 now = nowUs();
+    const qint64 limitUs = static_cast<qint64>(limitMs) * 1000;
+    int released = releaseNotes([this, now, limitUs](int channel, int note) {
+        // Notes played in the app have no port that could disappear
+        uint8_t source = m_activeNotes.source(channel, note);
+        if (source >= MAX_WATCHED_SOURCES) {
+            return false;
+        }
+        qint64 onset = m_activeNotes.onsetUs(channel, note);
+        qint64 closedAt = m_sourceClosedUs[source].load(std::memory_order_relaxed);
+        return closedAt > onset && now - onset >= limitUs;
+    });
+
+    if (released > 0) {
+        qDebug() << "SerialTransport: watchdog released" << released << "stuck notes";
+    }
+}
+
+void SerialTransport::serviceLiveEdits()
+{
+    if (!m_liveEditPending.load(std::memory_order_acquire) || !m_port->isOpen()) {
+        return;
+    }
+
+    // Wait for anything already queued to leave; bytesWritten re-enters here
+    if (!m_txBuffer.isEmpty() || m_port->bytesToWrite() > 0) {
+        return;
+    }
+
+    qint64 now = nowUs();
+    qint64 readyAt = qMax(m_wireIdleAtUs,
+                          m_lastLiveSendUs + m_liveMinIntervalUs.load(std::memory_order_relaxed));
+    if (readyAt > now) {
+        if (!m_liveTimer->isActive()) {
+            m_liveTimer->start(static_cast<int>((readyAt - now + 999) / 1000));
+        }
+        return;
+    }
+
+    std::array<LiveEditSlot, 6> pending;
+    {
+        QMutexLocker locker(&m_liveMutex);
+        pending.swap(m_liveEdits);
+        m_liveEditPending.store(false, std::memory_order_release);
+    }
+
+    for (const LiveEditSlot& slot : pending) {
+        if (!slot.patch.isEmpty()) {
+            appendMessage(slot.patch);
+        }
+        for (const QByteArray& msg : slot.params) {
+            appendMessage(msg);
+        }
+    }
+
+    m_lastLiveSendUs = now;
+    flushTx();
+}
+
+void SerialTransport::appendMessage(const char* data, int size)
+{
+    if (!m_runningStatusEnabled.load(std::memory_order_relaxed)) {
+        m_lastTxStatus = 0;
+        m_txBuffer.append(data, size);
+        return;
+    }
+
+    // Encode as a byte stream rather than per message, so live-edit buffers
+    // that hold several messages stay valid
+    for (int i = 0; i < size; i++) {
+        char c = data[i];
+        uint8_t byte = static_cast<uint8_t>(c);
+
+        if (byte >= 0xF8) {
+            // Realtime: pass through, receiver state restarts afterwards
+            m_txBuffer.append(c);
+            m_lastTxStatus = 0;
+        } else if (byte >= 0xF0) {
+            // SysEx / system common always cancel running status
+            m_txBuffer.append(c);
+            m_lastTxStatus = 0;
+            m_curStatus = 0;
+            m_txInSysEx = (byte == 0xF0);
+        } else if (byte >= 0x80) {
+            // Channel status - emitted lazily with the first data byte
+            m_txInSysEx = false;
+            m_curStatus = byte;
+            m_curDataIndex = 0;
+            m_curOutStatus = ((byte & 0xF0) == 0x80)
+                ? static_cast<uint8_t>(0x90 | (byte & 0x0F))  // Note-off -> note-on vel 0
+                : byte;
+        } else if (m_txInSysEx || m_curStatus == 0) {
+            m_txBuffer.append(c);
+        } else {
+            if (m_curDataIndex == 0 && m_curOutStatus != m_lastTxStatus) {
+                m_txBuffer.append(static_cast<char>(m_curOutStatus));
+                m_lastTxStatus = m_curOutStatus;
+            }
+
+            uint8_t type = m_curStatus & 0xF0;
+            if (type == 0x80 && m_curDataIndex == 1) {
+                byte = 0;
+            }
+            m_txBuffer.append(static_cast<char>(byte));
+
+            int length = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+            if (++m_curDataIndex >= length) {
+                m_curDataIndex = 0;
+            }
+        }
+    }
+}
+
+void SerialTransport::resetRunningStatus()
+{
+    m_lastTxStatus = 0;
+    m_curStatus = 0;
+    m_curOutStatus = 0;
+    m_curDataIndex = 0;
+    m_txInSysEx = false;
+}
+
+void SerialTransport::onReadyRead()
+{
+    qint64 timestampUs = nowUs();
+    QByteArray data = m_port->readAll();
+    if (m_echoTarget) {
+        echoReceived(data);
+    }
+    emit dataReceived(data, timestampUs);
+}
+
+void SerialTransport::setEchoTarget(MIDIManager* midi)
+{
+    m_echoTarget = midi;
+    m_echoParser.reset();
+}
+
+void SerialTransport::echoReceived(const QByteArray& data)
+{
+    MIDIManager* midi = m_echoTarget;
+    qint64 timestampUs = nowUs();
+
+    m_echoEvents.clear();
+    m_echoParser.parse(data.constData(), data.size(), m_echoEvents,
+                       [midi, timestampUs](const QByteArray& sysex) {
+        // Patch dumps are musical data; identity and acks are link protocol
+        if (sysex.size() > 4 &&
+            static_cast<uint8_t>(sysex[1]) == SysEx::MANUFACTURER_ID &&
+            static_cast<uint8_t>(sysex[3]) == SysEx::RESP_PATCH_DUMP) {
+            midi->sendToVirtualOutput(SysExMessage::fromBytes(
+                reinterpret_cast<const uint8_t*>(sysex.constData()), sysex.size(), timestampUs));
+        }
+    }, timestampUs);
+
+    for (const MidiMessage& message : m_echoEvents) {
+        midi->sendToVirtualOutput(message);
+    }
+}
+
+void SerialTransport::onError(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::NoError) {
+        return;
+    }
+
+    if (error == QSerialPort::ResourceError) {
+        // Device unplugged - stop accepting writes until reconnected
+        m_open.store(false, std::memory_order_release);
+    }
+
+    emit errorOccurred(error, m_port->errorString());
+}
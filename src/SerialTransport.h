@@ -0,0 +1,298 @@
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include <QObject>
+#include <QSerialPort>
+#include <QTimer>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "ActiveNotes.h"
+#include "LockFreeQueue.h"
+#include "MidiMessage.h"
+#include "MidiParser.h"
+
+class MIDIManager;
+class OutputScheduler;
+
+// Device RX buffer model for write pacing; see SerialManager::pacingProfile()
+struct PacingProfile {
+    int rxBufferBytes = 0;   // Device receive buffer; 0 disables pacing
+    int byteCostUs = 0;      // Firmware time to consume one byte
+    int sysexCostUs = 0;     // Extra time to act on a complete SysEx message
+
+    bool enabled() const { return rxBufferBytes > 0 && byteCostUs > 0; }
+};
+
+/**
+ * Owns the QSerialPort on a dedicated thread.
+ *
+ * Producers on any thread (MIDI forwarding, on-screen keyboard, live edit)
+ * push complete messages with enqueue(); the transport thread drains the
+ * ring and writes to the port, so GUI repaints and modal dialogs can no
+ * longer delay bytes on the wire. Everything except enqueue(), isOpen() and
+ * setCoalescing() must run on the transport thread.
+ *
+ * Writes are coalesced: each drain gathers every queued message into one
+ * buffer and issues a single QSerialPort::write(), flushing early once the
+ * buffer reaches the size threshold (one 64-byte USB packet by default).
+ *
+ * An optional running-status encoder drops repeated channel status bytes
+ * and rewrites note-off as note-on velocity 0 so note runs share a status.
+ *
+ * Messages are queued by priority class - system realtime, channel, bulk
+ * SysEx - and higher classes are always drained first. All channel voice
+ * and system common messages share one FIFO, so a program change, pedal or
+ * CC 123 keeps its place relative to the notes around it. Bulk frames are
+ * released one at a time, only after the previous frame has left the wire,
+ * so a note never waits behind more than one already-started SysEx frame.
+ * SysEx is never split; preemption happens at message boundaries.
+ *
+ * Boards with a small UART receive buffer can be paced: a token bucket models
+ * the device's RX buffer as a backlog of firmware work (per-byte cost plus a
+ * per-SysEx cost at each 0xF7) and holds bytes back while it is full.
+ *
+ * Live-edit traffic bypasses the rings: enqueueLatest() overwrites a per-channel
+ * slot, and the slot is only sent once the wire is idle and the max rate
+ * allows, so a fast mouse drag never builds a backlog the link can't drain.
+ *
+ * Continuous controllers (most CCs, channel pressure, pitch bend) can be
+ * thinned: each (channel, controller) has a latest-value slot, and the
+ * slots are flushed at an adaptive rate that backs off while the TX backlog
+ * is above a small target, so notes always find the link nearly idle.
+ * Superseded values are never sent. Before a note is written, its channel's
+ * pending slots are written first, so a note never overtakes a controller
+ * value sent before it. Thinning is off unless enabled.
+ *
+ * Every note-on/off written is recorded in an ActiveNotes bitmap, so a
+ * panic only sends the note-offs that are needed. An optional watchdog
+ * releases notes whose input source closed while they were held, once
+ * they have been held longer than the configured limit.
+ *
+ * Received bytes can also be echoed to a MIDIManager virtual output straight
+ * from this thread (setEchoTarget), so device traffic reaches the DAW
+ * without waiting on the GUI event loop.
+ */
+class SerialTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SerialTransport(QObject* parent = nullptr);
+    ~SerialTransport();
+
+    // Thread-safe: push one complete message for transmission. The
+    // QByteArray overload takes prebuilt SysEx or a run of short messages.
+    // With sendAtUs >= 0 (OutputScheduler::nowUs() clock) the message is
+    // never thinned, and its lateness is reported to the scheduler once
+    // its last byte is written.
+    bool enqueue(const MidiMessage& message, qint64 sendAtUs = -1);
+    bool enqueue(const SysExMessage& message, qint64 sendAtUs = -1);
+    bool enqueue(const QByteArray& message);
+    // Thread-safe: CMD_RECALL_PATCH (channel, slot) immediately ahead of
+    // message, in the channel FIFO so nothing on the channel can come between
+    bool enqueueAfterRecall(uint8_t channel, uint8_t slot, const MidiMessage& message);
+    bool isOpen() const { return m_open.load(std::memory_order_acquire); }
+    quint64 droppedMessages() const { return m_dropped.load(std::memory_order_relaxed); }
+    quint64 thinnedMessages() const { return m_thinned.load(std::memory_order_relaxed); }
+    int activeNoteCount() const { return m_activeNotes.count(); }
+    int queuedMessages() const
+    {
+        return static_cast<int>(m_realtimeRing.sizeApprox() + m_channelRing.sizeApprox() +
+                                m_bulkRing.sizeApprox());
+    }
+
+    // Thread-safe: the transport's monotonic clock, and when the final
+    // 0xF7 of the last CMD_PING frame was handed to the port on it
+    qint64 clockUs() const { return nowUs(); }
+    qint64 lastPingWrittenUs() const { return m_pingWrittenUs.load(std::memory_order_acquire); }
+
+    // Thread-safe: flush once the buffer holds flushBytes, or after at most
+    // maxLatencyMs (0 = flush at the end of every event-loop turn)
+    void setCoalescing(int flushBytes, int maxLatencyMs);
+
+    // Thread-safe: enable MIDI running-status compression on the wire
+    void setRunningStatusEnabled(bool enabled) { m_runningStatusEnabled.store(enabled); }
+
+    // Thread-safe: latest-value-wins live edit. key is LIVE_KEY_PATCH for a
+    // full patch load (supersedes pending parameters) or a parameter id.
+    void enqueueLatest(int channel, int key, QByteArray message);
+    void setLiveEditMaxRate(int hz);
+
+    static constexpr int LIVE_KEY_PATCH = -1;
+
+    // Thread-safe: coalesce continuous controllers to the latest value per
+    // (channel, controller), flushed at most maxRateHz times per second
+    void setControllerThinning(bool enabled, int maxRateHz);
+    static bool isThinnable(const MidiMessage& message);
+
+    // Thread-safe: stuck-note watchdog. Notes from a source that has since
+    // closed are released once held for limitMs (0 = off).
+    void setStuckNoteLimit(int limitMs);
+    int stuckNoteLimit() const { return m_stuckNoteLimitMs.load(std::memory_order_relaxed); }
+    void notifySourceClosed(int sourceId);
+
+    enum class Priority {
+        Realtime,     // System realtime (0xF8-0xFF)
+        Channel,      // Channel voice messages and system common, in order
+        Bulk          // SysEx
+    };
+    static Priority classify(uint8_t status);
+
+    // Transport thread only
+    bool open(const QString& portName, int baudRate, const PacingProfile& pacing = PacingProfile());
+    void close();
+    bool setBaudRate(int baudRate, const PacingProfile& pacing);
+    QString errorString() const { return m_port->errorString(); }
+    void setEchoTarget(MIDIManager* midi);
+    // Set before the transport thread starts; receives timed write reports
+    void setScheduler(OutputScheduler* scheduler) { m_scheduler = scheduler; }
+    // Drops queued note-ons, then a note-off for every tracked note; returns the count
+    int releaseActiveNotes();
+
+signals:
+    // timestampUs is read time on the transport clock (see clockUs())
+    void dataReceived(const QByteArray& data, qint64 timestampUs);
+    void errorOccurred(QSerialPort::SerialPortError error, const QString& message);
+
+private slots:
+    void onReadyRead();
+    void onError(QSerialPort::SerialPortError error);
+
+private:
+    void drain();
+    void flushTx();
+    void appendMessage(const char* data, int size);
+    void appendMessage(const QByteArray& message) { appendMessage(message.constData(), message.size()); }
+    void resetRunningStatus();
+    void echoReceived(const QByteArray& data);
+    void scheduleDrain();
+    struct QueuedMessage {
+        MidiMessage message;
+        int8_t recallChannel = -1;  // >= 0: recall recallSlot to this channel first
+        uint8_t recallSlot = 0;
+        qint64 sendAtUs = -1;       // >= 0: report write lateness to the scheduler
+    };
+    using MessageRing = LockFreeQueue<QueuedMessage, 1024>;
+
+    struct QueuedSysEx {
+        SysExMessage frame;
+        qint64 sendAtUs = -1;
+    };
+
+    // End offset in m_txBuffer of a timed message or a ping frame; reported
+    // once flushTx has written that far
+    struct TxMark {
+        int end = 0;
+        qint64 sendAtUs = 0;
+        bool ping = false;      // Stamp m_pingWrittenUs instead of reporting lateness
+    };
+
+    bool push(MessageRing& ring, const QueuedMessage& entry);
+    void drainRing(MessageRing& ring, int flushBytes);
+    void serviceBulk();
+    void serviceLiveEdits();
+    bool enqueueThinned(const MidiMessage& message);
+    void serviceThinned();
+    int appendThinSlot(int index);
+    void flushThinnedChannel(int channel);
+    qint64 txBacklogUs(qint64 now) const;
+    void checkStuckNotes();
+    template <typename Match>
+    int releaseNotes(Match match);
+    void onPaceTimer();
+    int pacedByteCount(qint64 now);
+    void markTx(qint64 sendAtUs, bool ping = false);
+    void completeMarks(int written);
+    qint64 nowUs() const { return m_clock.nsecsElapsed() / 1000; }
+
+    QSerialPort* m_port;
+    QTimer* m_flushTimer;
+    QTimer* m_liveTimer;
+    QTimer* m_bulkTimer;
+    QTimer* m_paceTimer;
+    QTimer* m_thinTimer;
+    QTimer* m_watchdogTimer;
+    QElapsedTimer m_clock;
+    MessageRing m_realtimeRing;
+    MessageRing m_channelRing;
+    LockFreeQueue<QueuedSysEx, 256> m_bulkRing;
+    QByteArray m_txBuffer;
+    std::vector<TxMark> m_txMarks;  // Ascending by end (transport thread only)
+    OutputScheduler* m_scheduler = nullptr;
+    std::atomic<int> m_flushBytes{DEFAULT_FLUSH_BYTES};
+    std::atomic<int> m_maxLatencyMs{0};
+    std::atomic<bool> m_runningStatusEnabled{false};
+
+    // Running-status encoder state (transport thread only)
+    uint8_t m_lastTxStatus = 0;   // Last status byte actually put on the wire
+    uint8_t m_curStatus = 0;      // Status of the message being encoded
+    uint8_t m_curOutStatus = 0;   // m_curStatus after note-off rewrite
+    int m_curDataIndex = 0;
+    bool m_txInSysEx = false;
+
+    // Pending live edits, one slot per FM channel
+    struct LiveEditSlot {
+        QByteArray patch;               // Latest full patch load, if any
+        QMap<int, QByteArray> params;   // Latest message per parameter
+    };
+    QMutex m_liveMutex;
+    std::array<LiveEditSlot, 6> m_liveEdits;   // Guarded by m_liveMutex
+    std::atomic<bool> m_liveEditPending{false};
+    std::atomic<int> m_liveMinIntervalUs{1000000 / DEFAULT_LIVE_EDIT_RATE_HZ};
+    qint64 m_lastLiveSendUs = 0;
+    qint64 m_wireIdleAtUs = 0;    // Estimated time the UART finishes the last write
+    qint64 m_bulkIdleAtUs = 0;    // Estimated time the last bulk frame left the wire
+
+    static constexpr int MAX_WATCHED_SOURCES = 32;
+    static constexpr int THIN_SLOTS_PER_CHANNEL = 130;   // CC 0-127, channel pressure, pitch bend
+    static constexpr int THIN_SLOT_COUNT = 16 * THIN_SLOTS_PER_CHANNEL;
+
+    // Controller thinning: one slot per (channel, controller), holding
+    // THIN_PENDING | data1 << 8 | data2. A slot's index is queued only when
+    // it becomes pending, so the dirty ring can never overflow.
+    std::array<std::atomic<uint32_t>, THIN_SLOT_COUNT> m_thinSlots{};
+    LockFreeQueue<uint16_t, 4096> m_thinDirty;
+    std::atomic<bool> m_thinEnabled{false};
+    std::atomic<int> m_thinMinIntervalUs{1000000 / DEFAULT_THIN_RATE_HZ};
+    qint64 m_thinIntervalUs = 0;  // Current adaptive interval (transport thread only)
+    qint64 m_lastThinSendUs = 0;
+
+    // Notes sounding on the device (written on the transport thread only)
+    ActiveNotes m_activeNotes;
+    std::atomic<int> m_stuckNoteLimitMs{0};
+    std::array<std::atomic<qint64>, MAX_WATCHED_SOURCES> m_sourceClosedUs{};  // 0 = never closed
+
+    // Device RX buffer model (transport thread only)
+    PacingProfile m_pacing;
+    qint64 m_paceBacklogUs = 0;   // Unprocessed firmware work in the device
+    qint64 m_paceUpdatedUs = 0;
+
+    // RX echo to the virtual MIDI output (transport thread only)
+    MIDIManager* m_echoTarget = nullptr;
+    MidiParser m_echoParser;
+    std::vector<MidiMessage> m_echoEvents;
+
+    std::atomic<bool> m_open{false};
+    std::atomic<bool> m_drainScheduled{false};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_thinned{0};
+    std::atomic<qint64> m_pingWrittenUs{0};
+
+    static constexpr int DEFAULT_FLUSH_BYTES = 64;  // One full-speed USB packet
+    static constexpr int TX_BUFFER_RESERVE = 512;
+    static constexpr int TX_MARK_RESERVE = 64;
+    static constexpr int ECHO_EVENT_RESERVE = 64;
+    static constexpr int DEFAULT_LIVE_EDIT_RATE_HZ = 50;
+    static constexpr uint32_t THIN_PENDING = 0x80000000u;
+    static constexpr int DEFAULT_THIN_RATE_HZ = 200;
+    static constexpr qint64 THIN_TARGET_BACKLOG_US = 2000; // Controllers only fill the link to here
+    static constexpr qint64 THIN_MAX_INTERVAL_US = 50000;
+    static constexpr int WATCHDOG_INTERVAL_MS = 250;
+};
+
+#endif // SERIALTRANSPORT_H
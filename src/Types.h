@@ -29,6 +29,15 @@ struct FMOperator {
     }
 };
 
+/**
+ * Single FM patch parameter, for live edits that change one field.
+ * Operator fields are numbered in TFI byte order within an operator.
+ */
+enum class FMParam : uint8_t {
+    Mul = 0, Dt, Tl, Rs, Ar, Dr, Sr, Rr, Sl, Ssg,   // Per operator
+    Algorithm, Feedback                              // Patch-wide
+};
+
 /**
  * FM Patch (42 bytes total, TFI-compatible)
  * Matches Arduino FMPatch struct exactly
@@ -44,6 +53,14 @@ struct FMPatch {
                op == other.op;
     }
 
+    // Offset of a parameter within the 42-byte TFI layout (opIndex ignored for
+    // Algorithm/Feedback)
+    static int byteOffset(int opIndex, FMParam param) {
+        if (param == FMParam::Algorithm) return 0;
+        if (param == FMParam::Feedback) return 1;
+        return 2 + opIndex * 10 + static_cast<int>(param);
+    }
+
     // Serialize to 42-byte TFI format for SysEx
     std::array<uint8_t, 42> toBytes() const {
         std::array<uint8_t, 42> data;
@@ -114,14 +131,48 @@ namespace SysEx {
     constexpr uint8_t CMD_LOAD_PSG_ENV = 0x02;       // Load PSG envelope
     constexpr uint8_t CMD_STORE_FM_PATCH = 0x03;    // Store FM patch to slot
     constexpr uint8_t CMD_RECALL_PATCH = 0x04;      // Recall patch to channel
+    constexpr uint8_t CMD_SET_FM_PARAM = 0x05;      // Set one patch byte on channel
     constexpr uint8_t CMD_REQUEST_PATCH = 0x10;     // Request patch dump
     constexpr uint8_t CMD_REQUEST_ALL = 0x11;       // Request all patches
     constexpr uint8_t CMD_SET_MODE = 0x12;          // Set synth mode
     constexpr uint8_t CMD_PING = 0x13;              // Ping/identify
+    constexpr uint8_t CMD_BULK_FM_FRAME = 0x14;     // Store FM patch to slot, acknowledged
+    constexpr uint8_t CMD_SET_BAUD = 0x15;          // Switch serial baud rate
+    constexpr uint8_t CMD_REQUEST_TELEMETRY = 0x16; // Request load/overrun counters
 
     // Responses (Device → Host)
     constexpr uint8_t RESP_PATCH_DUMP = 0x80;       // Patch dump response
     constexpr uint8_t RESP_IDENTITY = 0x81;         // Identity response
+    constexpr uint8_t RESP_BULK_ACK = 0x82;         // Bulk frame acknowledgement
+    constexpr uint8_t RESP_BAUD_ACK = 0x83;         // Baud switch acknowledgement
+    constexpr uint8_t RESP_TELEMETRY = 0x84;        // Telemetry response
+
+    // Supported-baud mask bits (optional third identity byte)
+    constexpr uint8_t BAUD_500K = 0x01;
+    constexpr uint8_t BAUD_1M = 0x02;
+    constexpr uint8_t BAUD_2M = 0x04;
+
+    // Bulk ack status
+    constexpr uint8_t BULK_OK = 0x00;
+    constexpr uint8_t BULK_BAD_CHECKSUM = 0x01;
+
+    // 7-bit checksum over a bulk frame's slot and patch bytes
+    inline uint8_t checksum(const uint8_t* data, size_t length) {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < length; i++) {
+            sum = static_cast<uint8_t>(sum + data[i]);
+        }
+        return sum & 0x7F;
+    }
+
+    // Unsigned value sent as `count` 7-bit groups, least significant first
+    inline uint32_t decode7(const uint8_t* data, int count) {
+        uint32_t value = 0;
+        for (int i = count - 1; i >= 0; i--) {
+            value = (value << 7) | (data[i] & 0x7F);
+        }
+        return value;
+    }
 }
 
 /**
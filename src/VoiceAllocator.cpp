@@ -0,0 +1,288 @@
+#include "VoiceAllocator.h"
+#include <QDebug>
+#include <chrono>
+#include <limits>
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+int VoiceAllocator::setConfig(const Config& config, Output* out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Held notes would otherwise sound until the device is panicked
+    int count = 0;
+    for (int i = 0; i < VOICES; i++) {
+        const Voice& voice = m_voices[i];
+        if (voice.held) {
+            out[count].message = MidiMessage::make(static_cast<uint8_t>(0x80 | i),
+                                                   static_cast<uint8_t>(voice.note), 0, nowUs());
+            out[count].recallSlot = -1;
+            count++;
+        }
+    }
+
+    // Voices keep their loaded patch; only note state is reset
+    bool keepPatches = m_config.enabled && config.enabled;
+    m_config = config;
+    m_config.inputChannel = qBound(0, config.inputChannel, 15);
+    m_config.patchSlot = qBound(-1, config.patchSlot, 15);
+    m_config.releaseMs = qMax(0, config.releaseMs);
+    for (Voice& voice : m_voices) {
+        int loadedSlot = keepPatches ? voice.loadedSlot : -1;
+        voice = Voice();
+        voice.loadedSlot = loadedSlot;
+    }
+
+    m_activeChannel.store(m_config.enabled ? m_config.inputChannel : -1, std::memory_order_release);
+    qDebug() << "VoiceAllocator:" << (m_config.enabled ? "enabled on channel" : "disabled")
+             << m_config.inputChannel + 1 << policyName(m_config.policy);
+    return count;
+}
+
+VoiceAllocator::Config VoiceAllocator::config() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_config;
+}
+
+void VoiceAllocator::invalidatePatches()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (Voice& voice : m_voices) {
+        voice.loadedSlot = -1;
+    }
+}
+
+QString VoiceAllocator::policyName(Policy policy)
+{
+    switch (policy) {
+        case Policy::Oldest:       return "Oldest";
+        case Policy::Quietest:     return "Quietest";
+        case Policy::SameNote:     return "Same-note retrigger";
+        case Policy::ReleaseFirst: return "Release phase first";
+    }
+    return QString();
+}
+
+QStringList VoiceAllocator::policyNames()
+{
+    return {policyName(Policy::Oldest), policyName(Policy::Quietest),
+            policyName(Policy::SameNote), policyName(Policy::ReleaseFirst)};
+}
+
+// =============================================================================
+// Allocation
+// =============================================================================
+
+qint64 VoiceAllocator::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool VoiceAllocator::isIdle(const Voice& voice, qint64 now) const
+{
+    return !voice.held && (voice.note < 0 ||
+                           now - voice.releasedUs >= qint64(m_config.releaseMs) * 1000);
+}
+
+bool VoiceAllocator::isReleasing(const Voice& voice, qint64 now) const
+{
+    return !voice.held && !isIdle(voice, now);
+}
+
+int VoiceAllocator::pickVoice(uint8_t note, qint64 now) const
+{
+    if (m_config.policy == Policy::SameNote) {
+        for (int i = 0; i < VOICES; i++) {
+            if (m_voices[i].note == note && !isIdle(m_voices[i], now)) {
+                return i;
+            }
+        }
+    }
+
+    // Idle voices first: one that already holds the right patch, otherwise
+    // the one released longest ago
+    int best = -1;
+    for (int i = 0; i < VOICES; i++) {
+        const Voice& voice = m_voices[i];
+        if (!isIdle(voice, now)) continue;
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+        const Voice& current = m_voices[best];
+        bool patchMatch = m_config.patchSlot >= 0 && voice.loadedSlot == m_config.patchSlot;
+        bool currentMatch = m_config.patchSlot >= 0 && current.loadedSlot == m_config.patchSlot;
+        // Never-used voices count as released at the start of time
+        qint64 released = voice.note < 0 ? std::numeric_limits<qint64>::min() : voice.releasedUs;
+        qint64 currentReleased = current.note < 0 ? std::numeric_limits<qint64>::min()
+                                                  : current.releasedUs;
+        if (patchMatch != currentMatch) {
+            if (patchMatch) best = i;
+        } else if (released < currentReleased) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        return best;
+    }
+
+    // Every voice is busy - steal
+    auto oldest = [this](int a, int b) { return m_voices[a].order < m_voices[b].order; };
+    best = 0;
+    for (int i = 1; i < VOICES; i++) {
+        const Voice& voice = m_voices[i];
+        const Voice& current = m_voices[best];
+        switch (m_config.policy) {
+            case Policy::Quietest: {
+                // A releasing voice is quieter than any held one
+                int level = voice.held ? voice.velocity : 0;
+                int currentLevel = current.held ? current.velocity : 0;
+                if (level < currentLevel || (level == currentLevel && oldest(i, best))) {
+                    best = i;
+                }
+                break;
+            }
+            case Policy::ReleaseFirst: {
+                bool releasing = isReleasing(voice, now);
+                bool currentReleasing = isReleasing(current, now);
+                if (releasing != currentReleasing) {
+                    if (releasing) best = i;
+                } else if (releasing ? voice.releasedUs < current.releasedUs : oldest(i, best)) {
+                    best = i;
+                }
+                break;
+            }
+            case Policy::Oldest:
+            case Policy::SameNote:
+                if (oldest(i, best)) {
+                    best = i;
+                }
+                break;
+        }
+    }
+    return best;
+}
+
+int VoiceAllocator::process(const MidiMessage& message, Output* out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_config.enabled) {
+        return 0;
+    }
+
+    switch (message.type()) {
+        case 0x90:
+            return message.data2() > 0 ? noteOn(message, out) : noteOff(message, out);
+        case 0x80:
+            return noteOff(message, out);
+        case 0xA0:
+            // Poly pressure follows the voice playing that key
+            for (int i = 0; i < VOICES; i++) {
+                if (m_voices[i].held && m_voices[i].note == message.data1()) {
+                    out[0].message = message;
+                    out[0].message.bytes[0] = static_cast<uint8_t>(0xA0 | i);
+                    out[0].recallSlot = -1;
+                    return 1;
+                }
+            }
+            return 0;
+        case 0xC0:
+            // With managed patches a program change picks the slot; voices
+            // pick it up lazily on their next note. There are only 16 slots,
+            // so higher programs are ignored rather than wrapped
+            if (m_config.patchSlot >= 0) {
+                if (message.data1() < 16) {
+                    m_config.patchSlot = message.data1();
+                }
+                return 0;
+            }
+            return broadcast(message, out);
+        case 0xB0:
+            // All notes off / all sound off also end our view of the voices
+            if (message.data1() == 120 || message.data1() == 123) {
+                qint64 now = nowUs();
+                for (Voice& voice : m_voices) {
+                    if (voice.held) {
+                        voice.held = false;
+                        voice.releasedUs = now;
+                    }
+                }
+            }
+            return broadcast(message, out);
+        default:
+            return broadcast(message, out);
+    }
+}
+
+int VoiceAllocator::noteOn(const MidiMessage& message, Output* out)
+{
+    qint64 now = nowUs();
+    uint8_t note = message.data1();
+    int index = pickVoice(note, now);
+    Voice& voice = m_voices[index];
+    int count = 0;
+
+    // Stealing a held voice cuts its note first (also a same-note retrigger)
+    if (voice.held) {
+        out[count].message = MidiMessage::make(static_cast<uint8_t>(0x80 | index),
+                                               static_cast<uint8_t>(voice.note), 0,
+                                               message.timestampUs);
+        out[count].message.source = message.source;
+        out[count].recallSlot = -1;
+        count++;
+    }
+
+    out[count].message = message;
+    out[count].message.bytes[0] = static_cast<uint8_t>(0x90 | index);
+    out[count].recallSlot = -1;
+    if (m_config.patchSlot >= 0 && voice.loadedSlot != m_config.patchSlot) {
+        out[count].recallSlot = m_config.patchSlot;
+        voice.loadedSlot = m_config.patchSlot;
+    }
+    count++;
+
+    voice.note = note;
+    voice.velocity = message.data2();
+    voice.held = true;
+    voice.order = m_nextOrder++;
+    return count;
+}
+
+int VoiceAllocator::noteOff(const MidiMessage& message, Output* out)
+{
+    // Newest held voice for this key; stolen notes have nothing left to stop
+    int index = -1;
+    for (int i = 0; i < VOICES; i++) {
+        const Voice& voice = m_voices[i];
+        if (voice.held && voice.note == message.data1() &&
+            (index < 0 || voice.order > m_voices[index].order)) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        return 0;
+    }
+
+    Voice& voice = m_voices[index];
+    voice.held = false;
+    voice.releasedUs = nowUs();
+
+    out[0].message = message;
+    out[0].message.bytes[0] = static_cast<uint8_t>(message.type() | index);
+    out[0].recallSlot = -1;
+    return 1;
+}
+
+int VoiceAllocator::broadcast(const MidiMessage& message, Output* out)
+{
+    for (int i = 0; i < VOICES; i++) {
+        out[i].message = message;
+        out[i].message.bytes[0] = static_cast<uint8_t>(message.type() | i);
+        out[i].recallSlot = -1;
+    }
+    return VOICES;
+}
@@ -0,0 +1,111 @@
+#ifndef VOICEALLOCATOR_H
+#define VOICEALLOCATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include "MidiMessage.h"
+
+/**
+ * Host-side polyphonic voice allocation across the six FM channels.
+ *
+ * Notes on one input channel are spread over FM channels 0-5, replacing the
+ * firmware's poly mode. When every voice is busy, the policy decides which
+ * one is stolen:
+ *
+ * - Oldest:       the voice whose note started first
+ * - Quietest:     the voice with the lowest velocity (released voices first)
+ * - SameNote:     a voice already playing the same key is retriggered,
+ *                 otherwise the oldest
+ * - ReleaseFirst: voices in their release phase before held ones, then oldest
+ *
+ * Idle voices are always used before stealing. With a managed patch slot,
+ * the allocator remembers which slot each FM channel holds and sends a
+ * recall only to a channel that doesn't already have it; program changes
+ * on the input channel select the slot. Channel-wide messages (CC, pitch
+ * bend, pressure) are copied to every voice.
+ *
+ * process() may be called from several MIDI input threads and serializes
+ * on an internal mutex; handles() is a lock-free pre-check.
+ */
+class VoiceAllocator
+{
+public:
+    static constexpr int VOICES = 6;
+    static constexpr int MAX_OUTPUTS = VOICES;
+
+    enum class Policy {
+        Oldest,
+        Quietest,
+        SameNote,
+        ReleaseFirst
+    };
+
+    struct Config {
+        bool enabled = false;
+        int inputChannel = 0;       // 0-15
+        Policy policy = Policy::Oldest;
+        int patchSlot = -1;         // Slot every voice should hold (-1 = don't manage patches)
+        int releaseMs = 300;        // How long a released note is assumed to ring
+    };
+
+    // One message to send; recallSlot >= 0 means recall that slot to the
+    // message's channel first, in order
+    struct Output {
+        MidiMessage message;
+        int recallSlot = -1;
+    };
+
+    VoiceAllocator() = default;
+    VoiceAllocator(const VoiceAllocator&) = delete;
+    VoiceAllocator& operator=(const VoiceAllocator&) = delete;
+
+    // Fills out[] with note-offs for voices still held under the old
+    // config and returns how many to send
+    int setConfig(const Config& config, Output* out);
+    Config config() const;
+
+    // Forget which patch each channel holds (device reset, manual patch loads)
+    void invalidatePatches();
+
+    bool handles(const MidiMessage& message) const
+    {
+        int channel = m_activeChannel.load(std::memory_order_acquire);
+        return channel >= 0 && message.status() < 0xF0 && message.channel() == channel;
+    }
+
+    // Fills out[] and returns the number of messages to send
+    int process(const MidiMessage& message, Output* out);
+
+    static QString policyName(Policy policy);
+    static QStringList policyNames();
+
+private:
+    struct Voice {
+        int note = -1;              // Last note played (-1 = never used)
+        uint8_t velocity = 0;
+        bool held = false;
+        quint64 order = 0;          // Note-on sequence number
+        qint64 releasedUs = 0;
+        int loadedSlot = -1;        // Patch slot the FM channel holds (-1 = unknown)
+    };
+
+    int pickVoice(uint8_t note, qint64 now) const;
+    bool isIdle(const Voice& voice, qint64 now) const;
+    bool isReleasing(const Voice& voice, qint64 now) const;
+    int noteOn(const MidiMessage& message, Output* out);
+    int noteOff(const MidiMessage& message, Output* out);
+    int broadcast(const MidiMessage& message, Output* out);
+    static qint64 nowUs();
+
+    mutable std::mutex m_mutex;
+    Config m_config;                    // Guarded by m_mutex
+    std::array<Voice, VOICES> m_voices; // Guarded by m_mutex
+    quint64 m_nextOrder = 1;
+    std::atomic<int> m_activeChannel{-1};
+};
+
+#endif // VOICEALLOCATOR_H